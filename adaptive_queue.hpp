@@ -0,0 +1,443 @@
+/*
+ * ---------------------------------------
+ * File: adaptive_queue.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Queue that runs on a plain mutex while uncontended and migrates to
+ *   the lock-free HybridQueue ring when contention shows up, and back
+ */
+#ifndef _JULES_ADAPTIVE_QUEUE_HPP_
+#define _JULES_ADAPTIVE_QUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "hybrid_queue.hpp"
+#include "quiescing_gate.hpp"
+
+namespace Jules::utils
+{
+    enum class AdaptiveMode
+    {
+        Locked,   ///< std::deque under a mutex, cheapest when calls do not overlap
+        Lockfree, ///< HybridQueue ring, no lock on Push/Pop
+    };
+
+    inline const char *AdaptiveModeName(AdaptiveMode m)
+    {
+        return m == AdaptiveMode::Locked ? "locked" : "lockfree";
+    }
+
+    /// @brief when AdaptiveQueue switches, high and low marks differ so a
+    ///        load near one threshold does not flip the mode back and forth
+    struct AdaptivePolicy
+    {
+        std::uint32_t window = 1024;        ///< locked calls per decision
+        double contended_high = 0.02;       ///< go lock-free above this share of calls that found the mutex taken
+        std::uint32_t sample_every = 64;    ///< lock-free calls per thread between two concurrency samples
+        std::uint32_t samples = 64;         ///< samples per lock-free decision
+        double concurrent_low = 0.05;       ///< quiet window: below this share of samples overlapped another call
+        std::uint32_t quiet_windows = 4;    ///< consecutive quiet windows before going back to the mutex
+    };
+
+    /// @tparam T element type, default constructible and assignable
+    /// @note Starts in Locked mode. Every locked call first tries the mutex
+    ///       without blocking; when more than contended_high of a window of
+    ///       calls had to wait, the elements move to a HybridQueue ring and
+    ///       calls run lock-free behind a QuiescingGate. One call in
+    ///       sample_every per thread reads how many calls are in flight;
+    ///       after quiet_windows windows where almost no sample saw another
+    ///       call, the ring is quiesced and drained back to the deque.
+    ///       Order is kept across a migration. Semantics follow
+    ///       CrossThreadQueue (Push drops the oldest when full); in Lockfree
+    ///       mode the HybridQueue differences apply. There are no counters,
+    ///       latency, token bucket pacing or capture hooks.
+    template <typename T>
+    class AdaptiveQueue
+    {
+    public:
+        /// @param policy switching thresholds
+        /// @param ring_capacity initial cells of the lock-free ring
+        explicit AdaptiveQueue(AdaptivePolicy policy = AdaptivePolicy(), std::size_t ring_capacity = 1024)
+            : policy_(policy), ring_(ring_capacity)
+        {
+        }
+        AdaptiveQueue(const AdaptiveQueue &) = delete;
+        AdaptiveQueue &operator=(const AdaptiveQueue &) = delete;
+
+        /// @brief set capacity of queue, dropping the oldest elements until
+        ///        fewer than ic are left, as CrossThreadQueue does
+        /// @param ic target capacity of queue
+        void SetMaxCount(std::size_t ic);
+
+        /// @brief get capacity of queue
+        /// @return current capacity of queue
+        std::size_t GetMaxCount() { return max_count_.load(std::memory_order_relaxed); }
+
+        /// @brief get size of queue
+        /// @return current size of queue
+        std::size_t Size();
+
+        /// @brief check if queue is full
+        /// @return true for full
+        bool Full() { return Size() >= GetMaxCount(); }
+
+        /// @brief check if queue is empty
+        /// @return true for empty
+        bool Empty() { return Size() == 0; }
+
+        /// @brief try to push element into queue
+        /// @param t element
+        /// @return true for pushed false for full
+        bool Try_Push(const T &t);
+
+        /// @brief try to push all elements into queue, none if they do not fit
+        /// @param ts vector of elements
+        /// @return true for pushed false for full
+        bool Try_Push(const std::vector<T> &ts);
+
+        /// @brief push element into queue, dropping the oldest when full
+        /// @param t element
+        void Push(const T &t);
+
+        /// @brief push elements into queue, dropping the oldest when full
+        /// @param ts vector of elements
+        void Push(const std::vector<T> &ts);
+
+        /// @brief try to pop element from queue
+        /// @param t pointer to poped element
+        /// @return true for poped false for empty
+        bool Pop(T *t = nullptr);
+
+        /// @brief pop up to num elements
+        /// @param num max count of elements
+        /// @return poped elements
+        std::vector<T> Pop(std::size_t num);
+
+        /// @brief clear the queue
+        void Clear();
+
+        /// @brief erase first element equal to t
+        /// @param t element value to erase
+        /// @return true for erased false for not found
+        bool Erase(const T &t);
+
+        /// @brief Sleep auxiliary function(thread independent)
+        /// @param duration time duration in millisecond
+        static void Sleep(size_t duration)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+        }
+
+        /// @brief current mode, may change right after the call
+        AdaptiveMode Mode() const { return mode_.load(std::memory_order_relaxed); }
+
+        /// @brief mode switches so far, both directions
+        std::uint64_t Migrations() const { return migrations_.load(std::memory_order_relaxed); }
+
+    private:
+        /// @brief run locked() under the mutex or lockfree() inside the gate,
+        ///        whichever the current mode says, and feed the contention
+        ///        statistics; both must return the same type
+        template <typename LockedFn, typename LockfreeFn>
+        auto Run(LockedFn &&locked, LockfreeFn &&lockfree) -> decltype(locked());
+
+        void DropFront()
+        {
+            deque_.pop_front();
+        }
+
+        /// @brief count a locked call, caller holds mutex_
+        void ObserveLocked(bool contended);
+
+        /// @brief sample concurrency in lock-free mode, true when it is time to go back
+        bool ObserveLockfree();
+
+        /// @brief deque to ring, caller holds mutex_
+        void MigrateToLockfree();
+
+        /// @brief ring to deque, caller must be outside the gate
+        void MigrateToLocked();
+
+        AdaptivePolicy policy_;
+        std::atomic<AdaptiveMode> mode_{AdaptiveMode::Locked};
+        std::atomic<std::size_t> max_count_{std::numeric_limits<std::size_t>::max()};
+        std::atomic<std::uint64_t> migrations_{0};
+
+        // Locked mode, everything below mutex_ is guarded by it
+        std::mutex mutex_;
+        std::deque<T> deque_;
+        std::uint32_t calls_ = 0;
+        std::uint32_t contended_ = 0;
+
+        // Lockfree mode
+        QuiescingGate gate_; ///< closed while the ring is drained back
+        HybridQueue<T> ring_;
+        std::atomic<std::uint32_t> samples_{0};
+        std::atomic<std::uint32_t> overlapped_{0};
+        std::atomic<std::uint32_t> quiet_{0}; ///< consecutive quiet windows
+    };
+
+    template <typename T>
+    template <typename LockedFn, typename LockfreeFn>
+    auto AdaptiveQueue<T>::Run(LockedFn &&locked, LockfreeFn &&lockfree) -> decltype(locked())
+    {
+        for (;;)
+        {
+            if (mode_.load(std::memory_order_acquire) == AdaptiveMode::Locked)
+            {
+                std::unique_lock<std::mutex> lck(mutex_, std::try_to_lock);
+                bool contended = !lck.owns_lock();
+                if (contended)
+                    lck.lock();
+                if (mode_.load(std::memory_order_relaxed) == AdaptiveMode::Locked)
+                {
+                    auto r = locked();
+                    ObserveLocked(contended);
+                    return r;
+                }
+                continue; // migrated while we waited for the mutex
+            }
+
+            decltype(locked()) r;
+            bool back = false;
+            {
+                QuiescingGate::Scope scope(gate_);
+                if (mode_.load(std::memory_order_acquire) != AdaptiveMode::Lockfree)
+                    continue;
+                r = lockfree();
+                back = ObserveLockfree();
+            }
+            if (back)
+                MigrateToLocked();
+            return r;
+        }
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::ObserveLocked(bool contended)
+    {
+        calls_++;
+        contended_ += contended ? 1 : 0;
+        if (calls_ < policy_.window)
+            return;
+        bool busy = contended_ > policy_.contended_high * calls_;
+        calls_ = contended_ = 0;
+        if (busy)
+            MigrateToLockfree();
+    }
+
+    template <typename T>
+    bool AdaptiveQueue<T>::ObserveLockfree()
+    {
+        // shared by every queue of this thread, it only spaces the samples
+        static thread_local std::uint32_t tick = 0;
+        if (++tick < policy_.sample_every)
+            return false;
+        tick = 0;
+
+        if (gate_.Active() > 1)
+            overlapped_.fetch_add(1, std::memory_order_relaxed);
+        if (samples_.fetch_add(1, std::memory_order_relaxed) + 1 != policy_.samples)
+            return false;
+
+        // the thread completing a window judges it
+        samples_.store(0, std::memory_order_relaxed);
+        auto overlapped = overlapped_.exchange(0, std::memory_order_relaxed);
+        if (overlapped >= policy_.concurrent_low * policy_.samples)
+        {
+            quiet_.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return quiet_.fetch_add(1, std::memory_order_relaxed) + 1 >= policy_.quiet_windows;
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::MigrateToLockfree()
+    {
+        // the ring is idle: nothing has passed the gate since it was drained
+        ring_.SetMaxCount(max_count_.load(std::memory_order_relaxed));
+        for (auto &t : deque_)
+            ring_.Push(t);
+        deque_.clear();
+        samples_.store(0, std::memory_order_relaxed);
+        overlapped_.store(0, std::memory_order_relaxed);
+        quiet_.store(0, std::memory_order_relaxed);
+        migrations_.fetch_add(1, std::memory_order_relaxed);
+        mode_.store(AdaptiveMode::Lockfree, std::memory_order_release);
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::MigrateToLocked()
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (mode_.load(std::memory_order_relaxed) != AdaptiveMode::Lockfree)
+            return; // another thread got here first
+        gate_.Exclusive([&]
+                        {
+            T t;
+            while (ring_.Pop(&t))
+                deque_.push_back(std::move(t));
+            calls_ = contended_ = 0;
+            migrations_.fetch_add(1, std::memory_order_relaxed);
+            mode_.store(AdaptiveMode::Locked, std::memory_order_release); });
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::SetMaxCount(std::size_t ic)
+    {
+        Run([&]
+            {
+                max_count_.store(ic, std::memory_order_relaxed);
+                while (!deque_.empty() && deque_.size() >= ic)
+                    DropFront();
+                return true; },
+            [&]
+            {
+                max_count_.store(ic, std::memory_order_relaxed);
+                ring_.SetMaxCount(ic);
+                return true; });
+    }
+
+    template <typename T>
+    std::size_t AdaptiveQueue<T>::Size()
+    {
+        return Run([&]
+                   { return deque_.size(); },
+                   [&]
+                   { return ring_.Size(); });
+    }
+
+    template <typename T>
+    bool AdaptiveQueue<T>::Try_Push(const T &t)
+    {
+        return Run([&]
+                   {
+                       if (deque_.size() >= max_count_.load(std::memory_order_relaxed))
+                           return false;
+                       deque_.push_back(t);
+                       return true; },
+                   [&]
+                   { return ring_.Try_Push(t); });
+    }
+
+    template <typename T>
+    bool AdaptiveQueue<T>::Try_Push(const std::vector<T> &ts)
+    {
+        return Run([&]
+                   {
+                       if (ts.size() + deque_.size() > max_count_.load(std::memory_order_relaxed))
+                           return false;
+                       deque_.insert(deque_.end(), ts.begin(), ts.end());
+                       return true; },
+                   [&]
+                   { return ring_.Try_Push(ts); });
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::Push(const T &t)
+    {
+        Run([&]
+            {
+                deque_.push_back(t);
+                if (deque_.size() > max_count_.load(std::memory_order_relaxed))
+                    DropFront();
+                return true; },
+            [&]
+            {
+                ring_.Push(t);
+                return true; });
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::Push(const std::vector<T> &ts)
+    {
+        Run([&]
+            {
+                auto max = max_count_.load(std::memory_order_relaxed);
+                for (auto &t : ts)
+                {
+                    deque_.push_back(t);
+                    if (deque_.size() > max)
+                        DropFront();
+                }
+                return true; },
+            [&]
+            {
+                ring_.Push(ts);
+                return true; });
+    }
+
+    template <typename T>
+    bool AdaptiveQueue<T>::Pop(T *t /* = nullptr */)
+    {
+        return Run([&]
+                   {
+                       if (deque_.empty())
+                           return false;
+                       if (t)
+                           *t = std::move(deque_.front());
+                       deque_.pop_front();
+                       return true; },
+                   [&]
+                   { return ring_.Pop(t); });
+    }
+
+    template <typename T>
+    std::vector<T> AdaptiveQueue<T>::Pop(std::size_t num)
+    {
+        return Run([&]
+                   {
+                       auto sz = std::min(num, deque_.size());
+                       std::vector<T> ts(std::make_move_iterator(deque_.begin()),
+                                         std::make_move_iterator(deque_.begin() + sz));
+                       deque_.erase(deque_.begin(), deque_.begin() + sz);
+                       return ts; },
+                   [&]
+                   { return ring_.Pop(num); });
+    }
+
+    template <typename T>
+    void AdaptiveQueue<T>::Clear()
+    {
+        Run([&]
+            {
+                deque_.clear();
+                return true; },
+            [&]
+            {
+                ring_.Clear();
+                return true; });
+    }
+
+    template <typename T>
+    bool AdaptiveQueue<T>::Erase(const T &t)
+    {
+        return Run([&]
+                   {
+                       for (auto it = deque_.begin(); it != deque_.end(); ++it)
+                       {
+                           if (t == *it)
+                           {
+                               deque_.erase(it);
+                               return true;
+                           }
+                       }
+                       return false; },
+                   [&]
+                   { return ring_.Erase(t); });
+    }
+
+} // ! namespace Jules::utils
+
+#endif
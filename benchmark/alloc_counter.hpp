@@ -0,0 +1,138 @@
+/*
+ * ---------------------------------------
+ * File: alloc_counter.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Counts heap allocations made through global operator new/delete
+ * - Define JULES_BENCH_ALLOC_COUNTER_IMPL in exactly one translation unit
+ *   before including to install the replacement operators
+ */
+#ifndef _JULES_ALLOC_COUNTER_HPP_
+#define _JULES_ALLOC_COUNTER_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "../sharded_counter.hpp"
+
+namespace Jules::bench
+{
+    /// @brief process wide allocation totals
+    /// @note updated from every thread without a shared cache line; take a
+    ///       Snapshot before and after the measured section and subtract
+    class AllocCounter
+    {
+    public:
+        struct Snapshot
+        {
+            std::uint64_t allocs = 0;
+            std::uint64_t frees = 0;
+            std::uint64_t bytes = 0; ///< requested bytes, frees are not sized
+
+            Snapshot operator-(const Snapshot &o) const
+            {
+                return Snapshot{allocs - o.allocs, frees - o.frees, bytes - o.bytes};
+            }
+        };
+
+        static AllocCounter &Instance()
+        {
+            static AllocCounter counter;
+            return counter;
+        }
+
+        /// @brief true when the replacement operators are linked in
+        static bool &Installed()
+        {
+            static bool installed = false;
+            return installed;
+        }
+
+        void OnAlloc(std::size_t bytes)
+        {
+            allocs_.Add();
+            bytes_.Add(bytes);
+        }
+        void OnFree() { frees_.Add(); }
+
+        Snapshot Take() const { return Snapshot{allocs_.Load(), frees_.Load(), bytes_.Load()}; }
+
+    private:
+        AllocCounter() = default;
+
+        Jules::utils::ShardedCounter<> allocs_;
+        Jules::utils::ShardedCounter<> frees_;
+        Jules::utils::ShardedCounter<> bytes_;
+    };
+
+} // ! namespace Jules::bench
+
+#ifdef JULES_BENCH_ALLOC_COUNTER_IMPL
+namespace Jules::bench::detail
+{
+    inline void *CountedAlloc(std::size_t n)
+    {
+        AllocCounter::Instance().OnAlloc(n);
+        return malloc(n ? n : 1);
+    }
+
+    inline void CountedFree(void *p)
+    {
+        if (!p)
+            return;
+        AllocCounter::Instance().OnFree();
+        free(p);
+    }
+
+    static const bool kAllocCounterInstalled = (AllocCounter::Installed() = true);
+} // ! namespace Jules::bench::detail
+
+void *operator new(std::size_t n)
+{
+    if (auto *p = Jules::bench::detail::CountedAlloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n)
+{
+    return operator new(n);
+}
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept
+{
+    return Jules::bench::detail::CountedAlloc(n);
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept
+{
+    return Jules::bench::detail::CountedAlloc(n);
+}
+void operator delete(void *p) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete[](void *p) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete(void *p, std::size_t) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete[](void *p, std::size_t) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { Jules::bench::detail::CountedFree(p); }
+#ifdef __cpp_aligned_new
+void *operator new(std::size_t n, std::align_val_t a)
+{
+    Jules::bench::AllocCounter::Instance().OnAlloc(n);
+    void *p = nullptr;
+    if (posix_memalign(&p, static_cast<std::size_t>(a), n ? n : 1) == 0)
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n, std::align_val_t a)
+{
+    return operator new(n, a);
+}
+void operator delete(void *p, std::align_val_t) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { Jules::bench::detail::CountedFree(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { Jules::bench::detail::CountedFree(p); }
+#endif
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+// Phased load against one long-lived queue: quiet 1:1 traffic, a burst of
+// many producers and consumers, then quiet again. Prints throughput per
+// phase and, for the adaptive queue, the mode it ended the phase in, so
+// switching and its hysteresis can be seen next to the fixed variants.
+//
+// usage: bench_adaptive [variant|all] [elements_per_phase]
+#include "../adaptive_queue.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+    struct Phase
+    {
+        const char *name;
+        unsigned producers;
+        unsigned consumers;
+    };
+
+    const Phase kPhases[] = {
+        {"1p1c", 1, 1},
+        {"4p4c", 4, 4},
+        {"8p8c", 8, 8},
+        {"1p1c", 1, 1},
+        {"1p1c", 1, 1},
+    };
+
+    template <typename Queue>
+    struct Describe
+    {
+        static const char *Mode(Queue &) { return "-"; }
+        static std::uint64_t Migrations(Queue &) { return 0; }
+    };
+
+    template <typename T>
+    struct Describe<Jules::utils::AdaptiveQueue<T>>
+    {
+        static const char *Mode(Jules::utils::AdaptiveQueue<T> &q) { return Jules::utils::AdaptiveModeName(q.Mode()); }
+        static std::uint64_t Migrations(Jules::utils::AdaptiveQueue<T> &q) { return q.Migrations(); }
+    };
+
+    template <typename Queue>
+    double RunPhase(Queue &queue, const Phase &p, std::uint64_t elements)
+    {
+        auto per_producer = elements / p.producers;
+        auto total = per_producer * p.producers;
+        std::atomic<std::uint64_t> consumed{0};
+        std::atomic<bool> go{false};
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < p.producers; i++)
+        {
+            threads.emplace_back([&]
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::uint64_t n = 0; n < per_producer; n++)
+                    while (!queue.Try_Push(n))
+                        std::this_thread::yield(); });
+        }
+        for (unsigned i = 0; i < p.consumers; i++)
+        {
+            threads.emplace_back([&]
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                std::uint64_t v;
+                while (consumed.load(std::memory_order_relaxed) < total)
+                {
+                    if (queue.Pop(&v))
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                } });
+        }
+        auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return total / seconds;
+    }
+
+    template <typename Queue>
+    void Run(const char *variant, std::uint64_t elements)
+    {
+        Queue queue;
+        queue.SetMaxCount(4096);
+        for (auto &p : kPhases)
+        {
+            auto rate = RunPhase(queue, p, elements);
+            printf("%-10s %-6s %10.2f %-9s %10llu\n", variant, p.name, rate / 1e6, Describe<Queue>::Mode(queue),
+                   static_cast<unsigned long long>(Describe<Queue>::Migrations(queue)));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string variant = argc > 1 ? argv[1] : "all";
+    std::uint64_t elements = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+
+    printf("%-10s %-6s %10s %-9s %10s\n", "variant", "phase", "Melem/s", "mode", "migrations");
+    if (variant == "all" || variant == "ctq")
+        Run<Jules::utils::CrossThreadQueue<std::uint64_t>>("ctq", elements);
+    if (variant == "all" || variant == "hybrid")
+        Run<Jules::utils::HybridQueue<std::uint64_t>>("hybrid", elements);
+    if (variant == "all" || variant == "adaptive")
+        Run<Jules::utils::AdaptiveQueue<std::uint64_t>>("adaptive", elements);
+    return 0;
+}
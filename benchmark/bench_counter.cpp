@@ -0,0 +1,69 @@
+// Cost of counting one queue operation as writer threads are added:
+// a single shared atomic against ShardedCounter.
+#include "../sharded_counter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+    constexpr std::uint64_t kOpsPerThread = 5000000;
+
+    template <typename Fn>
+    double NsPerOp(unsigned threads, Fn &&add)
+    {
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&]
+                                 {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::uint64_t i = 0; i < kOpsPerThread; i++)
+                    add(); });
+        }
+        while (ready.load() != threads)
+            std::this_thread::yield();
+        auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &w : workers)
+            w.join();
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        // cpu time per op: stays flat while writers do not contend
+        auto cpus = std::min(threads, std::max(1u, std::thread::hardware_concurrency()));
+        return ns * cpus / static_cast<double>(kOpsPerThread * threads);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned max_threads = std::max(2u, std::thread::hardware_concurrency() * 2);
+    if (argc > 1)
+        max_threads = static_cast<unsigned>(atoi(argv[1]));
+
+    printf("%8s %16s %16s\n", "threads", "atomic ns/op", "sharded ns/op");
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        std::atomic<std::uint64_t> shared{0};
+        Jules::utils::ShardedCounter<> sharded;
+        auto a = NsPerOp(threads, [&]
+                         { shared.fetch_add(1, std::memory_order_relaxed); });
+        auto s = NsPerOp(threads, [&]
+                         { sharded.Add(); });
+        if (shared.load() != sharded.Load())
+        {
+            printf("count mismatch\n");
+            return 1;
+        }
+        printf("%8u %16.2f %16.2f\n", threads, a, s);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Allocations per post of TaskExecutor: a task whose capture fits the
+// InlineTask slot must be posted and run without touching the heap, a
+// larger one takes exactly one heap block. Workers are started before the
+// counted window; std::function through a CrossThreadQueue with one
+// consumer thread is the reference. Exits 1 if either claim fails.
+//
+// usage: bench_executor [tasks]
+#include "../cross_thread_queue.hpp"
+#include "../task_executor.hpp"
+#define JULES_BENCH_ALLOC_COUNTER_IMPL
+#include "alloc_counter.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <stdio.h>
+
+using Jules::bench::AllocCounter;
+
+namespace
+{
+    constexpr std::size_t kInline = 48;
+
+    /// @brief capture of three words, fits the default slot
+    struct Small
+    {
+        std::atomic<std::uint64_t> *sum;
+        std::uint64_t a, b;
+        void operator()() const { sum->fetch_add(a + b, std::memory_order_relaxed); }
+    };
+
+    /// @brief capture of 17 words, falls back to the heap
+    struct Large
+    {
+        std::atomic<std::uint64_t> *sum;
+        std::array<std::uint64_t, 16> v;
+        void operator()() const { sum->fetch_add(v[0] + v[15], std::memory_order_relaxed); }
+    };
+
+    static_assert(Jules::utils::InlineTask<kInline>::FitsInline<Small>(), "Small must be stored inline");
+    static_assert(!Jules::utils::InlineTask<kInline>::FitsInline<Large>(), "Large must fall back to the heap");
+
+    Small MakeTask(std::atomic<std::uint64_t> *sum, std::uint64_t i, Small *) { return Small{sum, i, 1}; }
+    Large MakeTask(std::atomic<std::uint64_t> *sum, std::uint64_t i, Large *)
+    {
+        Large t{sum, {}};
+        t.v[0] = i;
+        t.v[15] = 1;
+        return t;
+    }
+
+    void Print(const char *variant, const char *capture, std::uint64_t tasks, double ns,
+               const AllocCounter::Snapshot &allocs, const char *verdict)
+    {
+        printf("%-14s %-8s %8.1f ns/post %8.3f allocs/post %10.1f bytes/post  %s\n", variant, capture, ns,
+               static_cast<double>(allocs.allocs) / tasks, static_cast<double>(allocs.bytes) / tasks, verdict);
+    }
+
+    /// @param expected allocations per post the executor promises for Task
+    template <typename Task>
+    bool RunExecutor(const char *capture, std::uint64_t tasks, std::uint64_t expected)
+    {
+        std::atomic<std::uint64_t> sum{0};
+        Jules::utils::TaskExecutor<kInline> executor(2, 1024, 16);
+        auto before = AllocCounter::Instance().Take();
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < tasks; i++)
+            executor.Post(MakeTask(&sum, i, static_cast<Task *>(nullptr)));
+        executor.WaitIdle();
+        auto ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / tasks;
+        auto allocs = AllocCounter::Instance().Take() - before;
+
+        bool ok = allocs.allocs == expected * tasks && sum.load() == tasks * (tasks - 1) / 2 + tasks;
+        Print("executor", capture, tasks, ns, allocs, ok ? "ok" : "FAIL");
+        return ok;
+    }
+
+    template <typename Task>
+    void RunFunctionQueue(const char *capture, std::uint64_t tasks)
+    {
+        std::atomic<std::uint64_t> sum{0};
+        Jules::utils::CrossThreadQueue<std::function<void()>> queue;
+        queue.SetMaxCount(1024);
+        std::thread worker([&]
+                           {
+            std::function<void()> f;
+            for (std::uint64_t got = 0; got < tasks;)
+            {
+                if (queue.Pop(&f))
+                {
+                    f();
+                    got++;
+                }
+                else
+                    std::this_thread::yield();
+            } });
+        auto before = AllocCounter::Instance().Take();
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < tasks; i++)
+        {
+            std::function<void()> f = MakeTask(&sum, i, static_cast<Task *>(nullptr));
+            while (!queue.Try_Push(f))
+                std::this_thread::yield();
+        }
+        while (sum.load() != tasks * (tasks - 1) / 2 + tasks)
+            std::this_thread::yield();
+        auto ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / tasks;
+        auto allocs = AllocCounter::Instance().Take() - before;
+        worker.join();
+        Print("ctq_function", capture, tasks, ns, allocs, "(reference)");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::uint64_t tasks = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    if (tasks == 0)
+        tasks = 1;
+    if (!AllocCounter::Installed())
+        printf("allocation counter not installed\n");
+
+    bool ok = RunExecutor<Small>("inline", tasks, 0);
+    ok &= RunExecutor<Large>("heap", tasks, 1);
+    RunFunctionQueue<Small>("inline", tasks);
+    RunFunctionQueue<Large>("heap", tasks);
+    printf("%s\n", ok ? "allocations per post as promised" : "allocations per post VIOLATED");
+    return ok ? 0 : 1;
+}
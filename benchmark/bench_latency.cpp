@@ -0,0 +1,161 @@
+// Open-loop latency benchmark: producers send at a fixed target rate and
+// latency is measured from the intended send time, so a stalled queue is
+// charged for every element it held back (no coordinated omission).
+// Offered load doubles each step until the queue saturates.
+//
+// usage: bench_latency [variant|all] [start_rate/s] [step_ms] [producers]
+#include "../adaptive_queue.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../fair_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include "../queue_clock.hpp"
+#include "../queue_hooks.hpp"
+#include "hdr_histogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using Jules::bench::HdrHistogram;
+using Jules::utils::QueueClock;
+
+namespace
+{
+    struct Item
+    {
+        std::int64_t intended_ns = 0; ///< when the schedule said to send
+        std::int64_t sent_ns = 0;      ///< when the push actually started
+    };
+
+    struct Step
+    {
+        double offered = 0;  ///< elements/s asked for
+        double achieved = 0; ///< elements/s consumed
+        HdrHistogram corrected;
+        HdrHistogram naive;
+    };
+
+    /// @brief wait until QueueClock reaches t, sleeping while far away
+    void WaitUntil(std::int64_t t)
+    {
+        for (;;)
+        {
+            auto left = t - QueueClock::NowNs();
+            if (left <= 0)
+                return;
+            if (left > 200000)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(left - 100000));
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    template <typename Queue>
+    Step RunStep(double rate, std::chrono::milliseconds duration, unsigned producers)
+    {
+        Queue queue;
+        Step step;
+        step.offered = rate;
+
+        auto interval = static_cast<std::int64_t>(1e9 * producers / rate);
+        auto start = QueueClock::NowNs() + 1000000;
+        auto end = start + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        std::atomic<std::uint64_t> sent{0};
+        std::atomic<unsigned> running{producers};
+
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < producers; p++)
+        {
+            threads.emplace_back([&, p]
+                                 {
+                // producers are staggered to spread sends evenly
+                std::uint64_t n = 0;
+                for (auto t = start + interval * p / producers; t < end; t += interval, n++)
+                {
+                    WaitUntil(t);
+                    queue.Push(Item{t, QueueClock::NowNs()});
+                }
+                sent.fetch_add(n);
+                running.fetch_sub(1); });
+        }
+
+        std::uint64_t received = 0;
+        std::int64_t last = start;
+        Item item;
+        for (;;)
+        {
+            if (queue.Pop(&item))
+            {
+                last = QueueClock::NowNs();
+                step.corrected.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, last - item.intended_ns)));
+                step.naive.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, last - item.sent_ns)));
+                received++;
+                continue;
+            }
+            if (running.load() == 0 && received == sent.load())
+                break;
+            std::this_thread::yield();
+        }
+        for (auto &t : threads)
+            t.join();
+
+        step.achieved = received * 1e9 / static_cast<double>(std::max<std::int64_t>(last - start, 1));
+        return step;
+    }
+
+    void Print(const char *variant, const Step &s)
+    {
+        printf("%-10s %12.0f %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f %12.1f\n",
+               variant, s.offered, s.achieved,
+               s.corrected.Quantile(0.5) / 1e3, s.corrected.Quantile(0.9) / 1e3,
+               s.corrected.Quantile(0.99) / 1e3, s.corrected.Quantile(0.999) / 1e3,
+               s.corrected.Max() / 1e3, s.naive.Quantile(0.99) / 1e3);
+    }
+
+    template <typename Queue>
+    void Sweep(const char *variant, double rate, std::chrono::milliseconds duration, unsigned producers)
+    {
+        for (int i = 0; i < 24; i++, rate *= 2)
+        {
+            auto step = RunStep<Queue>(rate, duration, producers);
+            Print(variant, step);
+            // saturated: consumer falls behind the offered load
+            if (step.achieved < 0.9 * step.offered)
+                break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string variant = argc > 1 ? argv[1] : "all";
+    double rate = argc > 2 ? atof(argv[2]) : 10000;
+    std::chrono::milliseconds duration(argc > 3 ? atoi(argv[3]) : 500);
+    unsigned producers = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 2;
+    if (rate <= 0 || producers == 0)
+    {
+        printf("usage: %s [ctq|ctq_hooks|fair|hybrid|adaptive|all] [start_rate/s] [step_ms] [producers]\n", argv[0]);
+        return 1;
+    }
+
+    printf("clock %s, %u producers, 1 consumer, %lld ms per step, latency in us from intended send time\n",
+           QueueClock::Source(), producers, static_cast<long long>(duration.count()));
+    printf("%-10s %12s %12s %10s %10s %10s %10s %10s %12s\n",
+           "variant", "offered/s", "achieved/s", "p50", "p90", "p99", "p99.9", "max", "naive p99");
+    if (variant == "all" || variant == "ctq")
+        Sweep<Jules::utils::CrossThreadQueue<Item>>("ctq", rate, duration, producers);
+    if (variant == "all" || variant == "ctq_hooks")
+        Sweep<Jules::utils::CrossThreadQueue<Item, Jules::utils::CounterHooks>>("ctq_hooks", rate, duration, producers);
+    if (variant == "all" || variant == "fair")
+        Sweep<Jules::utils::FairQueue<Item>>("fair", rate, duration, producers);
+    if (variant == "all" || variant == "hybrid")
+        Sweep<Jules::utils::HybridQueue<Item>>("hybrid", rate, duration, producers);
+    if (variant == "all" || variant == "adaptive")
+        Sweep<Jules::utils::AdaptiveQueue<Item>>("adaptive", rate, duration, producers);
+    return 0;
+}
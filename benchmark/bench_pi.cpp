@@ -0,0 +1,194 @@
+// Cost and benefit of the priority inheritance lock (pi_mutex.hpp):
+//  1. uncontended lock/unlock of std::mutex and PiMutex;
+//  2. CrossThreadQueue throughput with each lock, 1p1c and 4p4c;
+//  3. priority inversion: on one CPU a SCHED_FIFO low priority producer
+//     holds the queue lock for hold_us per push (a hooks policy that
+//     spins, standing in for a long critical section), a medium priority
+//     thread burns the CPU in bursts, and a high priority consumer times
+//     how long Pop takes to get the lock. Without inheritance the consumer
+//     waits for the medium thread's burst; with it only for hold_us.
+//     Needs permission for SCHED_FIFO (root or CAP_SYS_NICE).
+//
+// usage: bench_pi [elements] [inversion_ms] [hold_us] [burst_ms]
+#include "../cpu_affinity.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../pi_mutex.hpp"
+#include "../queue_clock.hpp"
+#include "hdr_histogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using Jules::bench::HdrHistogram;
+using Jules::utils::PiMutex;
+using Jules::utils::QueueClock;
+
+namespace
+{
+    void SpinFor(std::int64_t ns)
+    {
+        auto end = QueueClock::NowNs() + ns;
+        while (QueueClock::NowNs() < end)
+            ;
+    }
+
+    /// @brief holds the queue lock hold_ns longer on every push
+    struct SlowPushHooks
+    {
+        void OnPush(const void *, std::size_t) { SpinFor(hold_ns); }
+        void OnPop(const void *, std::size_t) {}
+        void OnDrop(const void *, std::size_t) {}
+        void OnWaitBegin(const void *) {}
+        void OnWaitEnd(const void *) {}
+
+        std::int64_t hold_ns = 0;
+    };
+
+    template <typename Lock>
+    double LockNs(std::uint64_t rounds)
+    {
+        Lock lock;
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < rounds; i++)
+        {
+            lock.lock();
+            lock.unlock();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / rounds;
+    }
+
+    template <typename Lock>
+    double QueueNs(unsigned producers, unsigned consumers, std::uint64_t elements)
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::NoHooks, Lock> queue;
+        queue.SetMaxCount(4096);
+        auto per_producer = elements / producers;
+        auto total = per_producer * producers;
+        std::atomic<std::uint64_t> consumed{0};
+        std::vector<std::thread> threads;
+        auto begin = std::chrono::steady_clock::now();
+        for (unsigned p = 0; p < producers; p++)
+            threads.emplace_back([&]
+                                 {
+                for (std::uint64_t i = 0; i < per_producer; i++)
+                    while (!queue.Try_Push(i))
+                        std::this_thread::yield(); });
+        for (unsigned c = 0; c < consumers; c++)
+            threads.emplace_back([&]
+                                 {
+                std::uint64_t v;
+                while (consumed.load(std::memory_order_relaxed) < total)
+                {
+                    if (queue.Pop(&v))
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                } });
+        for (auto &t : threads)
+            t.join();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / total;
+    }
+
+#ifdef __linux__
+    bool SetFifo(int priority)
+    {
+        sched_param param{};
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    /// @brief Pop lock latency of the high priority consumer
+    template <typename Lock>
+    bool Inversion(const char *variant, std::chrono::milliseconds duration, std::int64_t hold_ns, std::int64_t burst_ns)
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t, SlowPushHooks, Lock> queue;
+        queue.GetHooks().hold_ns = hold_ns;
+        std::atomic<bool> running{true};
+        std::atomic<bool> denied{false};
+        HdrHistogram latency;
+
+        auto rt = [&](int priority)
+        {
+            Jules::utils::PinCurrentThread(0);
+            if (!SetFifo(priority))
+                denied = true;
+        };
+        std::thread low([&]
+                        {
+            rt(10);
+            for (std::uint64_t i = 0; running; i++)
+            {
+                queue.Push(i);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            } });
+        std::thread medium([&]
+                           {
+            rt(20);
+            while (running)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                SpinFor(burst_ns);
+            } });
+        std::thread high([&]
+                         {
+            rt(30);
+            std::uint64_t v;
+            while (running)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                auto begin = QueueClock::NowNs();
+                queue.Pop(&v);
+                latency.Record(QueueClock::ElapsedNs(begin));
+            } });
+        std::this_thread::sleep_for(duration);
+        running = false;
+        low.join();
+        medium.join();
+        high.join();
+        if (denied)
+        {
+            printf("%-10s inversion skipped, SCHED_FIFO not permitted\n", variant);
+            return false;
+        }
+        printf("%-10s %10llu %10.1f %10.1f %10.1f %10.1f\n", variant, static_cast<unsigned long long>(latency.Count()),
+               latency.Quantile(0.5) / 1e3, latency.Quantile(0.99) / 1e3, latency.Quantile(0.999) / 1e3,
+               latency.Max() / 1e3);
+        return true;
+    }
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    std::uint64_t elements = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    std::chrono::milliseconds duration(argc > 2 ? atoi(argv[2]) : 2000);
+    std::int64_t hold_ns = (argc > 3 ? atoll(argv[3]) : 50) * 1000;
+    std::int64_t burst_ns = (argc > 4 ? atoll(argv[4]) : 5) * 1000000;
+
+    printf("uncontended lock+unlock: std::mutex %.1f ns, PiMutex %.1f ns\n\n", LockNs<std::mutex>(10000000),
+           LockNs<PiMutex>(10000000));
+
+    printf("%-10s %-6s %10s\n", "lock", "case", "ns/elem");
+    printf("%-10s %-6s %10.1f\n", "mutex", "1p1c", QueueNs<std::mutex>(1, 1, elements));
+    printf("%-10s %-6s %10.1f\n", "pi_mutex", "1p1c", QueueNs<PiMutex>(1, 1, elements));
+    printf("%-10s %-6s %10.1f\n", "mutex", "4p4c", QueueNs<std::mutex>(4, 4, elements));
+    printf("%-10s %-6s %10.1f\n", "pi_mutex", "4p4c", QueueNs<PiMutex>(4, 4, elements));
+
+#ifdef __linux__
+    printf("\nhigh priority Pop lock latency in us, low priority holds the lock %lld us, medium bursts %lld ms\n",
+           static_cast<long long>(hold_ns / 1000), static_cast<long long>(burst_ns / 1000000));
+    printf("%-10s %10s %10s %10s %10s %10s\n", "lock", "pops", "p50", "p99", "p99.9", "max");
+    if (Inversion<std::mutex>("mutex", duration, hold_ns, burst_ns))
+        Inversion<PiMutex>("pi_mutex", duration, hold_ns, burst_ns);
+#endif
+    return 0;
+}
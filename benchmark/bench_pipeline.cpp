@@ -0,0 +1,367 @@
+// Pipeline simulation: stages connected by queues, described by a config
+// file (see pipeline.conf). Reports end-to-end throughput and latency, and
+// per stage utilization, so queue choices can be compared on a topology
+// before it is deployed.
+//
+// usage: bench_pipeline [config]
+#include "../adaptive_queue.hpp"
+#include "../cpu_affinity.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../fair_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include "../queue_clock.hpp"
+#include "../queue_hooks.hpp"
+#include "hdr_histogram.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using Jules::bench::HdrHistogram;
+using Jules::utils::QueueClock;
+
+namespace
+{
+    struct Item
+    {
+        std::int64_t created_ns = 0; ///< intended send time at the source
+    };
+
+    /// @brief queue variant behind a common interface, one per config edge
+    class Edge
+    {
+    public:
+        virtual ~Edge() = default;
+        virtual bool TryPush(Item *item) = 0;
+        virtual bool Pop(Item **item) = 0;
+        virtual std::size_t Size() = 0;
+
+        std::string name;
+        std::string variant;
+        std::size_t peak = 0; ///< deepest size seen by the monitor
+    };
+
+    template <typename Queue>
+    class QueueEdge : public Edge
+    {
+    public:
+        explicit QueueEdge(std::size_t capacity)
+        {
+            if (capacity)
+                queue_.SetMaxCount(capacity);
+        }
+        bool TryPush(Item *item) override { return queue_.Try_Push(item); }
+        bool Pop(Item **item) override { return queue_.Pop(item); }
+        std::size_t Size() override { return queue_.Size(); }
+
+    private:
+        Queue queue_;
+    };
+
+    template <>
+    bool QueueEdge<Jules::utils::FairQueue<Item *>>::TryPush(Item *item)
+    {
+        return queue_.Try_Push(Jules::utils::FairQueue<Item *>::CurrentProducer(), item);
+    }
+
+    std::unique_ptr<Edge> MakeEdge(const std::string &variant, std::size_t capacity)
+    {
+        if (variant == "ctq")
+            return std::unique_ptr<Edge>(new QueueEdge<Jules::utils::CrossThreadQueue<Item *>>(capacity));
+        if (variant == "ctq_hooks")
+            return std::unique_ptr<Edge>(new QueueEdge<Jules::utils::CrossThreadQueue<Item *, Jules::utils::CounterHooks>>(capacity));
+        if (variant == "fair")
+            return std::unique_ptr<Edge>(new QueueEdge<Jules::utils::FairQueue<Item *>>(capacity));
+        if (variant == "hybrid")
+            return std::unique_ptr<Edge>(new QueueEdge<Jules::utils::HybridQueue<Item *>>(capacity));
+        if (variant == "adaptive")
+            return std::unique_ptr<Edge>(new QueueEdge<Jules::utils::AdaptiveQueue<Item *>>(capacity));
+        return nullptr;
+    }
+
+    /// @brief service time distribution, samples in ns
+    struct Distribution
+    {
+        std::string kind;
+        double a = 0;
+        double b = 0;
+
+        std::int64_t Sample(std::mt19937_64 &gen) const
+        {
+            double us = a;
+            if (kind == "uniform")
+                us = std::uniform_real_distribution<double>(a, b)(gen);
+            else if (kind == "exp")
+                us = std::exponential_distribution<double>(1.0 / a)(gen);
+            else if (kind == "lognormal")
+                us = std::lognormal_distribution<double>(std::log(a), b)(gen);
+            return static_cast<std::int64_t>(us * 1e3);
+        }
+    };
+
+    struct Stage
+    {
+        std::string name;
+        Edge *in = nullptr;
+        Edge *out = nullptr;
+        unsigned threads = 1;
+        bool spin = false;
+        Distribution service;
+        std::vector<int> cpus; ///< threads pinned round robin, empty for unpinned
+
+        std::atomic<std::uint64_t> items{0};
+        std::atomic<std::int64_t> busy_ns{0};    ///< simulated service
+        std::atomic<std::int64_t> blocked_ns{0}; ///< waiting for room downstream
+    };
+
+    struct Pipeline
+    {
+        std::uint64_t items = 1000;
+        double rate = 0;
+        std::chrono::seconds timeout{60};
+        Edge *source = nullptr;
+        Edge *sink = nullptr;
+        std::map<std::string, std::unique_ptr<Edge>> edges;
+        std::vector<std::unique_ptr<Stage>> stages;
+    };
+
+    bool Fail(int line, const std::string &msg)
+    {
+        fprintf(stderr, "config line %d: %s\n", line, msg.c_str());
+        return false;
+    }
+
+    bool Parse(std::istream &in, Pipeline &p)
+    {
+        std::string text, source, sink;
+        int line = 0;
+        while (std::getline(in, text))
+        {
+            line++;
+            auto hash = text.find('#');
+            if (hash != std::string::npos)
+                text.resize(hash);
+            std::istringstream ss(text);
+            std::string key;
+            if (!(ss >> key))
+                continue;
+
+            if (key == "items")
+            {
+                if (!(ss >> p.items) || p.items == 0)
+                    return Fail(line, "items needs a positive count");
+            }
+            else if (key == "source")
+            {
+                if (!(ss >> source))
+                    return Fail(line, "source needs a queue");
+                ss >> p.rate;
+            }
+            else if (key == "sink")
+            {
+                if (!(ss >> sink))
+                    return Fail(line, "sink needs a queue");
+            }
+            else if (key == "timeout")
+            {
+                long s = 0;
+                if (!(ss >> s) || s <= 0)
+                    return Fail(line, "timeout needs seconds");
+                p.timeout = std::chrono::seconds(s);
+            }
+            else if (key == "queue")
+            {
+                std::string name, variant;
+                std::size_t capacity = 0;
+                if (!(ss >> name >> variant))
+                    return Fail(line, "queue needs a name and a variant");
+                ss >> capacity;
+                auto edge = MakeEdge(variant, capacity);
+                if (!edge)
+                    return Fail(line, "unknown queue variant " + variant);
+                edge->name = name;
+                edge->variant = variant;
+                p.edges[name] = std::move(edge);
+            }
+            else if (key == "stage")
+            {
+                std::unique_ptr<Stage> stage(new Stage);
+                std::string in_name, out_name, mode;
+                if (!(ss >> stage->name >> in_name >> out_name >> stage->threads >> mode >> stage->service.kind >> stage->service.a))
+                    return Fail(line, "stage needs name, in, out, threads, sleep|spin and a distribution");
+                auto &d = stage->service;
+                if ((d.kind == "uniform" || d.kind == "lognormal") && !(ss >> d.b))
+                    return Fail(line, d.kind + " needs two parameters");
+                if (d.kind != "fixed" && d.kind != "uniform" && d.kind != "exp" && d.kind != "lognormal")
+                    return Fail(line, "unknown distribution " + d.kind);
+                if (mode != "sleep" && mode != "spin")
+                    return Fail(line, "mode must be sleep or spin");
+                stage->spin = mode == "spin";
+                if (!p.edges.count(in_name) || !p.edges.count(out_name))
+                    return Fail(line, "queues must be declared before stages using them");
+                stage->in = p.edges[in_name].get();
+                stage->out = p.edges[out_name].get();
+                if (stage->threads == 0)
+                    return Fail(line, "stage needs at least one thread");
+                p.stages.push_back(std::move(stage));
+            }
+            else if (key == "pin")
+            {
+                std::string name, list;
+                if (!(ss >> name >> list))
+                    return Fail(line, "pin needs a stage and a cpu list");
+                auto it = std::find_if(p.stages.begin(), p.stages.end(), [&](const std::unique_ptr<Stage> &s)
+                                       { return s->name == name; });
+                if (it == p.stages.end())
+                    return Fail(line, "stages must be declared before pinning them");
+                (*it)->cpus = Jules::utils::CpuTopology::ParseList(list);
+                if ((*it)->cpus.empty())
+                    return Fail(line, "bad cpu list " + list);
+            }
+            else
+                return Fail(line, "unknown key " + key);
+        }
+
+        if (!p.edges.count(source) || !p.edges.count(sink))
+            return Fail(line, "source and sink must name declared queues");
+        p.source = p.edges[source].get();
+        p.sink = p.edges[sink].get();
+        for (auto &s : p.stages)
+            if (s->in == p.sink)
+                return Fail(line, "sink queue " + sink + " must not feed a stage");
+        return true;
+    }
+
+    void RunStage(Stage &stage, unsigned index, const std::atomic<bool> &running)
+    {
+        if (!stage.cpus.empty() && !Jules::utils::PinCurrentThread(stage.cpus[index % stage.cpus.size()]))
+            fprintf(stderr, "stage %s: cannot pin thread %u\n", stage.name.c_str(), index);
+        std::mt19937_64 gen(std::hash<std::string>()(stage.name) + index);
+        unsigned idle = 0;
+        Item *item = nullptr;
+        while (running.load(std::memory_order_relaxed))
+        {
+            if (!stage.in->Pop(&item))
+            {
+                if (++idle < 64)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                continue;
+            }
+            idle = 0;
+
+            auto begin = QueueClock::NowNs();
+            auto until = begin + stage.service.Sample(gen);
+            if (stage.spin)
+            {
+                while (QueueClock::NowNs() < until)
+                {
+                }
+            }
+            else
+                std::this_thread::sleep_for(std::chrono::nanoseconds(until - begin));
+            auto served = QueueClock::NowNs();
+
+            while (!stage.out->TryPush(item) && running.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+            stage.items.fetch_add(1, std::memory_order_relaxed);
+            stage.busy_ns.fetch_add(served - begin, std::memory_order_relaxed);
+            stage.blocked_ns.fetch_add(QueueClock::NowNs() - served, std::memory_order_relaxed);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "pipeline.conf";
+    std::ifstream file(path);
+    if (!file)
+    {
+        printf("usage: %s [config], cannot open %s\n", argv[0], path);
+        return 1;
+    }
+    Pipeline p;
+    if (!Parse(file, p))
+        return 1;
+
+    std::vector<Item> pool(p.items);
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (auto &stage : p.stages)
+        for (unsigned i = 0; i < stage->threads; i++)
+            threads.emplace_back(RunStage, std::ref(*stage), i, std::cref(running));
+
+    // source: open loop at the configured rate, latency counts from the
+    // intended send time so a backed-up pipeline is not under-reported
+    auto start = QueueClock::NowNs();
+    auto interval = p.rate > 0 ? static_cast<std::int64_t>(1e9 / p.rate) : 0;
+    std::thread source([&]
+                       {
+        for (std::uint64_t i = 0; i < p.items && running.load(std::memory_order_relaxed); i++)
+        {
+            auto intended = start + interval * static_cast<std::int64_t>(i);
+            while (QueueClock::NowNs() < intended)
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            pool[i].created_ns = interval ? intended : QueueClock::NowNs();
+            while (!p.source->TryPush(&pool[i]) && running.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+        } });
+
+    // sink and monitor
+    HdrHistogram latency;
+    std::uint64_t received = 0;
+    std::int64_t last = start;
+    auto deadline = start + std::chrono::duration_cast<std::chrono::nanoseconds>(p.timeout).count();
+    Item *item = nullptr;
+    while (received < p.items && QueueClock::NowNs() < deadline)
+    {
+        for (auto &kv : p.edges)
+            kv.second->peak = std::max(kv.second->peak, kv.second->Size());
+        if (!p.sink->Pop(&item))
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        last = QueueClock::NowNs();
+        latency.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, last - item->created_ns)));
+        received++;
+    }
+    auto elapsed = std::max<std::int64_t>(last - start, 1);
+    running = false;
+    source.join();
+    for (auto &t : threads)
+        t.join();
+
+    printf("%s: %llu/%llu items in %.3f s, %.1f items/s%s\n", path,
+           static_cast<unsigned long long>(received), static_cast<unsigned long long>(p.items),
+           elapsed / 1e9, received * 1e9 / elapsed, received < p.items ? " (timeout)" : "");
+    printf("end-to-end latency ms: p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n",
+           latency.Quantile(0.5) / 1e6, latency.Quantile(0.9) / 1e6, latency.Quantile(0.99) / 1e6,
+           latency.Quantile(0.999) / 1e6, latency.Max() / 1e6);
+
+    printf("\n%-12s %8s %10s %8s %8s %12s\n", "stage", "threads", "items", "util%", "block%", "service us");
+    for (auto &s : p.stages)
+    {
+        auto capacity = static_cast<double>(elapsed) * s->threads;
+        auto items = s->items.load();
+        printf("%-12s %8u %10llu %8.1f %8.1f %12.1f\n", s->name.c_str(), s->threads,
+               static_cast<unsigned long long>(items), 100.0 * s->busy_ns.load() / capacity,
+               100.0 * s->blocked_ns.load() / capacity, items ? s->busy_ns.load() / 1e3 / items : 0.0);
+    }
+
+    printf("\n%-12s %-10s %8s\n", "queue", "variant", "peak");
+    for (auto &kv : p.edges)
+        printf("%-12s %-10s %8zu\n", kv.first.c_str(), kv.second->variant.c_str(), kv.second->peak);
+    return received == p.items ? 0 : 2;
+}
@@ -0,0 +1,183 @@
+// Placement sweep: one producer and one consumer pinned to a pair of CPUs
+// for each relation found in /sys/devices/system/cpu (same CPU, SMT
+// siblings, same LLC, different LLC, different socket), measuring
+// streaming throughput and ping-pong round trip per queue variant.
+//
+// usage: bench_placement [variant|all] [elements]
+#include "../cpu_affinity.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../fair_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include "../queue_clock.hpp"
+#include "../queue_hooks.hpp"
+#include "hdr_histogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using Jules::bench::HdrHistogram;
+using Jules::utils::CpuTopology;
+using Jules::utils::Placement;
+using Jules::utils::QueueClock;
+
+namespace
+{
+    template <typename Queue>
+    struct Ops
+    {
+        static bool TryPush(Queue &q, std::uint64_t v) { return q.Try_Push(v); }
+    };
+
+    template <typename T>
+    struct Ops<Jules::utils::FairQueue<T>>
+    {
+        static bool TryPush(Jules::utils::FairQueue<T> &q, std::uint64_t v)
+        {
+            return q.Try_Push(Jules::utils::FairQueue<T>::CurrentProducer(), v);
+        }
+    };
+
+    /// @brief both threads pin themselves, then wait for each other;
+    ///        false when either pin could not be applied
+    inline bool PinAndMeet(int cpu, std::atomic<int> &ready, std::atomic<bool> &pinned)
+    {
+        if (!Jules::utils::PinCurrentThread(cpu))
+            pinned = false;
+        ready++;
+        while (ready.load() < 2)
+            std::this_thread::yield();
+        return pinned.load();
+    }
+
+    /// @brief elements/s streamed from a thread on cpu a to one on cpu b;
+    ///        false when the placement could not be applied
+    template <typename Queue>
+    bool Stream(int a, int b, std::uint64_t elements, double *rate)
+    {
+        Queue queue;
+        queue.SetMaxCount(4096);
+        std::atomic<int> ready{0};
+        std::atomic<bool> pinned{true};
+        std::thread producer([&]
+                             {
+            if (!PinAndMeet(a, ready, pinned))
+                return;
+            for (std::uint64_t i = 0; i < elements; i++)
+                while (!Ops<Queue>::TryPush(queue, i))
+                    std::this_thread::yield(); });
+        if (!PinAndMeet(b, ready, pinned))
+        {
+            producer.join();
+            return false;
+        }
+        auto begin = QueueClock::NowNs();
+        std::uint64_t v;
+        for (std::uint64_t got = 0; got < elements;)
+        {
+            if (queue.Pop(&v))
+                got++;
+            else
+                std::this_thread::yield();
+        }
+        auto ns = QueueClock::NowNs() - begin;
+        producer.join();
+        *rate = elements * 1e9 / static_cast<double>(ns);
+        return true;
+    }
+
+    /// @brief round trip through two queues between cpu a and cpu b;
+    ///        false when the placement could not be applied
+    template <typename Queue>
+    bool PingPong(int a, int b, std::uint64_t rounds, HdrHistogram *rtt)
+    {
+        Queue ping, pong;
+        std::atomic<int> ready{0};
+        std::atomic<bool> pinned{true};
+        std::thread echo([&]
+                         {
+            if (!PinAndMeet(b, ready, pinned))
+                return;
+            std::uint64_t v;
+            for (std::uint64_t i = 0; i < rounds; i++)
+            {
+                while (!ping.Pop(&v))
+                    std::this_thread::yield();
+                Ops<Queue>::TryPush(pong, v);
+            } });
+        if (!PinAndMeet(a, ready, pinned))
+        {
+            echo.join();
+            return false;
+        }
+        std::uint64_t v;
+        for (std::uint64_t i = 0; i < rounds; i++)
+        {
+            auto begin = QueueClock::NowNs();
+            Ops<Queue>::TryPush(ping, i);
+            while (!pong.Pop(&v))
+                std::this_thread::yield();
+            rtt->Record(QueueClock::ElapsedNs(begin));
+        }
+        echo.join();
+        return true;
+    }
+
+    template <typename Queue>
+    void Sweep(const char *variant, const CpuTopology &topology, std::uint64_t elements)
+    {
+        for (std::size_t p = 0; p < static_cast<std::size_t>(Placement::Count); p++)
+        {
+            auto placement = static_cast<Placement>(p);
+            int a = 0, b = 0;
+            if (!topology.FindPair(placement, &a, &b))
+            {
+                printf("%-10s %-13s %9s %12s\n", variant, Jules::utils::PlacementName(placement), "-", "not present");
+                continue;
+            }
+            double rate = 0;
+            HdrHistogram rtt;
+            if (!Stream<Queue>(a, b, elements, &rate) || !PingPong<Queue>(a, b, elements / 100 + 1, &rtt))
+            {
+                printf("%-10s %-13s %4d,%-4d %12s\n", variant, Jules::utils::PlacementName(placement), a, b, "pin failed");
+                continue;
+            }
+            printf("%-10s %-13s %4d,%-4d %12.2f %10llu %10llu %10llu\n", variant, Jules::utils::PlacementName(placement),
+                   a, b, rate / 1e6, static_cast<unsigned long long>(rtt.Quantile(0.5)),
+                   static_cast<unsigned long long>(rtt.Quantile(0.99)), static_cast<unsigned long long>(rtt.Max()));
+        }
+        Jules::utils::UnpinCurrentThread();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string variant = argc > 1 ? argv[1] : "all";
+    std::uint64_t elements = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+
+    // only CPUs this process may run on, read before any thread is pinned
+    auto topology = CpuTopology::Read();
+    if (topology.Cpus().empty())
+    {
+        printf("no usable CPU topology in /sys/devices/system/cpu\n");
+        return 1;
+    }
+    printf("%zu usable cpus\n%-6s %-6s %-8s %-6s\n", topology.Cpus().size(), "cpu", "core", "package", "llc");
+    for (auto &c : topology.Cpus())
+        printf("%-6d %-6d %-8d %-6d\n", c.cpu, c.core, c.package, c.llc);
+
+    printf("\n%-10s %-13s %9s %12s %10s %10s %10s\n", "variant", "placement", "cpus", "Melem/s", "rtt p50", "rtt p99", "rtt max");
+    if (variant == "all" || variant == "ctq")
+        Sweep<Jules::utils::CrossThreadQueue<std::uint64_t>>("ctq", topology, elements);
+    if (variant == "all" || variant == "ctq_hooks")
+        Sweep<Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::CounterHooks>>("ctq_hooks", topology, elements);
+    if (variant == "all" || variant == "fair")
+        Sweep<Jules::utils::FairQueue<std::uint64_t>>("fair", topology, elements);
+    if (variant == "all" || variant == "hybrid")
+        Sweep<Jules::utils::HybridQueue<std::uint64_t>>("hybrid", topology, elements);
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Checks of the real-time profile (realtime_queue.hpp):
+//  - allocations: global operator new calls while a producer and a
+//    consumer move elements through try-only calls, next to
+//    CrossThreadQueue for contrast. Both threads are started and parked
+//    before the window opens, so thread set-up is not counted;
+//  - system calls: in a forked child the producer and the consumer thread
+//    both enter seccomp strict mode (only read, write, _exit and sigreturn
+//    allowed) before their polling loops, so any other system call kills
+//    that thread before it reports its result. A control run calls
+//    sched_yield in the consumer after entering strict mode and must be
+//    killed.
+//
+// usage: bench_realtime [elements]
+#include "../cross_thread_queue.hpp"
+#include "../realtime_queue.hpp"
+#define JULES_BENCH_ALLOC_COUNTER_IMPL
+#include "alloc_counter.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <stdio.h>
+#ifdef __linux__
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using Jules::bench::AllocCounter;
+
+namespace
+{
+    constexpr std::size_t kCapacity = 4096;
+
+    /// @param yield give the CPU up while full; sched_yield is a system
+    ///        call, so not under seccomp
+    template <typename Queue>
+    void Produce(Queue &queue, std::uint64_t elements, bool yield)
+    {
+        for (std::uint64_t i = 0; i < elements; i++)
+            while (!queue.Try_Push(i))
+                if (yield)
+                    std::this_thread::yield();
+    }
+
+    /// @param yield give the CPU up while empty, as for Produce
+    template <typename Queue>
+    std::uint64_t Consume(Queue &queue, std::uint64_t elements, bool yield)
+    {
+        std::uint64_t sum = 0, v = 0;
+        for (std::uint64_t got = 0; got < elements;)
+        {
+            if (queue.Pop(&v))
+            {
+                sum += v;
+                got++;
+            }
+            else if (yield)
+                std::this_thread::yield();
+        }
+        return sum;
+    }
+
+    /// @brief start both sides, park them, then count only what they
+    ///        allocate between the go signal and their last element
+    template <typename Queue>
+    bool CheckAllocations(const char *variant, Queue &queue, std::uint64_t elements, bool expect_none)
+    {
+        std::atomic<int> ready{0}, done{0};
+        std::atomic<bool> go{false};
+        std::uint64_t sum = 0;
+        auto side = [&](bool producer)
+        {
+            return std::thread([&, producer]
+                               {
+                ready++;
+                while (!go.load())
+                    ;
+                if (producer)
+                    Produce(queue, elements, true);
+                else
+                    sum = Consume(queue, elements, true);
+                done++; });
+        };
+        auto producer = side(true);
+        auto consumer = side(false);
+        while (ready.load() < 2)
+            std::this_thread::yield();
+
+        auto before = AllocCounter::Instance().Take();
+        auto begin = std::chrono::steady_clock::now();
+        go = true;
+        while (done.load() < 2)
+            ;
+        auto ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / elements;
+        auto allocs = AllocCounter::Instance().Take() - before;
+        producer.join();
+        consumer.join();
+
+        bool ok = !expect_none || (allocs.allocs == 0 && sum == elements * (elements - 1) / 2);
+        printf("%-14s %-12s %8.1f ns/elem %10llu allocs %12llu bytes  %s\n", variant, "allocations", ns,
+               static_cast<unsigned long long>(allocs.allocs), static_cast<unsigned long long>(allocs.bytes),
+               expect_none ? (ok ? "ok" : "FAIL") : "(reference)");
+        return ok;
+    }
+
+#ifdef __linux__
+    /// @brief one result written to the pipe by a side that survived
+    struct Report
+    {
+        std::uint64_t producer; ///< 1 from the producer, 0 from the consumer
+        std::uint64_t value;    ///< elements pushed, or sum of elements popped
+    };
+
+    /// @brief producer and consumer threads of a forked child under seccomp strict mode
+    /// @return true when both threads reported the right values, or for the
+    ///         control run when only the consumer was killed before reporting
+    bool CheckSyscalls(const char *variant, std::uint64_t elements, bool control)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return false;
+        auto pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            Jules::utils::RealtimeQueue<std::uint64_t> queue(kCapacity);
+            std::atomic<int> ready{0};
+            auto side = [&](bool producer)
+            {
+                return std::thread([&, producer]
+                                   {
+                    if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_STRICT) != 0)
+                        _exit(2);
+                    // from here on every call must stay in user space
+                    ready++;
+                    while (ready.load() < 2)
+                        ;
+                    Report r{producer, 0};
+                    if (producer)
+                    {
+                        Produce(queue, elements, false);
+                        r.value = elements;
+                    }
+                    else
+                    {
+                        if (control)
+                            syscall(SYS_sched_yield);
+                        r.value = Consume(queue, elements, false);
+                    }
+                    if (write(fds[1], &r, sizeof(r)) != sizeof(r))
+                        r.value = 0;
+                    // thread exit only, exit_group is not allowed
+                    syscall(SYS_exit, 0); });
+            };
+            auto producer = side(true);
+            auto consumer = side(false);
+            producer.join();
+            consumer.join();
+            _exit(0);
+        }
+        close(fds[1]);
+        bool produced = false, consumed = false;
+        Report r;
+        while (read(fds[0], &r, sizeof(r)) == sizeof(r))
+        {
+            if (r.producer)
+                produced = r.value == elements;
+            else
+                consumed = r.value == elements * (elements - 1) / 2;
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        // strict mode kills only the offending thread, the child exits normally
+        bool exited = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        bool clean = exited && produced && consumed;
+        bool killed = exited && produced && !consumed;
+        bool ok = control ? killed : clean;
+        printf("%-14s %-12s %s, %s\n", variant, "syscalls", clean ? "no syscall" : (killed ? "killed by seccomp" : "failed"),
+               ok ? "ok" : "FAIL");
+        return ok;
+    }
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    std::uint64_t elements = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    if (!AllocCounter::Installed())
+        printf("allocation counter not installed\n");
+
+    bool ok = true;
+    {
+        Jules::utils::RealtimeQueue<std::uint64_t> queue(kCapacity);
+        ok &= CheckAllocations("realtime", queue, elements, true);
+    }
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t> queue;
+        queue.SetMaxCount(kCapacity);
+        CheckAllocations("ctq", queue, elements, false);
+    }
+#ifdef __linux__
+    ok &= CheckSyscalls("realtime", elements, false);
+    ok &= CheckSyscalls("control_yield", 1000, true);
+#else
+    printf("syscall check needs Linux seccomp, skipped\n");
+#endif
+    printf("%s\n", ok ? "real-time profile holds" : "real-time profile VIOLATED");
+    return ok ? 0 : 1;
+}
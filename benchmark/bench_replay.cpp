@@ -0,0 +1,329 @@
+// Capture and replay of queue calls (queue_capture.hpp).
+//
+//   bench_replay record <file> [ms]              capture a bursty synthetic workload
+//   bench_replay replay <file> [variant|all] [asap]
+//
+// Replay starts one thread per captured thread and issues the same calls
+// at the same offsets (or back to back with "asap") against the chosen
+// queue variant, reporting wall time, call latency and elements moved.
+// An unread (consumer token elements put back at the front) has no
+// counterpart in the variants, so it is folded into the batch pop that
+// cached the elements, which is replayed as the net pop it amounted to.
+#include "../cross_thread_queue.hpp"
+#include "../fair_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include "../queue_capture.hpp"
+#include "../queue_clock.hpp"
+#include "../queue_hooks.hpp"
+#include "hdr_histogram.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using Jules::bench::HdrHistogram;
+using Jules::utils::CaptureOp;
+using Jules::utils::CaptureRecord;
+using Jules::utils::CaptureThread;
+using Jules::utils::QueueCapture;
+using Jules::utils::QueueClock;
+
+namespace
+{
+    /// @brief replays one call, returns elements moved
+    template <typename Queue>
+    struct Ops
+    {
+        static std::size_t Apply(Queue &q, const CaptureRecord &r, std::vector<std::uint64_t> &batch, std::uint64_t &next)
+        {
+            auto n = r.Requested();
+            switch (r.Op())
+            {
+            case CaptureOp::Push:
+                q.Push(next++);
+                return 1;
+            case CaptureOp::PushBatch:
+                Fill(batch, n, next);
+                q.Push(batch);
+                return n;
+            case CaptureOp::TryPush:
+                return q.Try_Push(next++) ? 1 : 0;
+            case CaptureOp::TryPushBatch:
+            {
+                auto before = q.Size();
+                Fill(batch, n, next);
+                q.Try_Push(batch); // returns false even when pushed
+                return q.Size() > before ? n : 0;
+            }
+            case CaptureOp::Pop:
+            {
+                std::uint64_t v;
+                return q.Pop(&v) ? 1 : 0;
+            }
+            case CaptureOp::PopBatch:
+                return q.Pop(static_cast<std::size_t>(n)).size();
+            case CaptureOp::Erase:
+                return q.Erase(next - 1) ? 1 : 0;
+            case CaptureOp::Clear:
+                q.Clear();
+                return 0;
+            case CaptureOp::SetMaxCount:
+                q.SetMaxCount(n == CaptureRecord::kMaxRequested ? std::numeric_limits<std::size_t>::max() : n);
+                return 0;
+            default:
+                return 0;
+            }
+        }
+
+        static void Fill(std::vector<std::uint64_t> &batch, std::size_t n, std::uint64_t &next)
+        {
+            batch.resize(n);
+            for (auto &v : batch)
+                v = next++;
+        }
+    };
+
+    /// @brief FairQueue has no batch push and no Erase; batches are pushed
+    ///        one by one and Erase is skipped
+    template <typename T>
+    struct Ops<Jules::utils::FairQueue<T>>
+    {
+        using Queue = Jules::utils::FairQueue<T>;
+
+        static std::size_t Apply(Queue &q, const CaptureRecord &r, std::vector<std::uint64_t> &, std::uint64_t &next)
+        {
+            auto n = r.Requested();
+            auto key = Queue::CurrentProducer();
+            std::size_t done = 0;
+            switch (r.Op())
+            {
+            case CaptureOp::Push:
+            case CaptureOp::PushBatch:
+                for (std::size_t i = 0; i < n; i++)
+                    q.Push(key, next++);
+                return n;
+            case CaptureOp::TryPush:
+            case CaptureOp::TryPushBatch:
+                for (std::size_t i = 0; i < n; i++)
+                    done += q.Try_Push(key, next++) ? 1 : 0;
+                return done;
+            case CaptureOp::Pop:
+            {
+                std::uint64_t v;
+                return q.Pop(&v) ? 1 : 0;
+            }
+            case CaptureOp::PopBatch:
+                return q.Pop(static_cast<std::size_t>(n)).size();
+            case CaptureOp::Clear:
+                q.Clear();
+                return 0;
+            case CaptureOp::SetMaxCount:
+                q.SetMaxCount(n == CaptureRecord::kMaxRequested ? std::numeric_limits<std::size_t>::max() : n);
+                return 0;
+            default:
+                return 0;
+            }
+        }
+    };
+
+    int Record(const std::string &path, std::chrono::milliseconds duration)
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t> queue;
+        QueueCapture capture;
+        queue.EnableCapture(&capture);
+        queue.SetMaxCount(1024);
+
+        std::atomic<bool> running{true};
+        std::vector<std::thread> threads;
+        // producers: bursts of single and batched pushes separated by idle gaps
+        for (unsigned p = 0; p < 2; p++)
+        {
+            threads.emplace_back([&, p]
+                                 {
+                std::mt19937 gen(p + 1);
+                std::vector<std::uint64_t> batch;
+                std::uint64_t v = 0;
+                while (running)
+                {
+                    auto burst = std::uniform_int_distribution<int>(1, 64)(gen);
+                    for (int i = 0; i < burst; i++)
+                    {
+                        if (gen() % 4 == 0)
+                        {
+                            batch.assign(std::uniform_int_distribution<int>(2, 16)(gen), v++);
+                            queue.Push(batch);
+                        }
+                        else
+                            queue.Try_Push(v++);
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(std::uniform_int_distribution<int>(50, 2000)(gen)));
+                } });
+        }
+        // consumers: one pops singly, one in batches of up to 32
+        for (unsigned c = 0; c < 2; c++)
+        {
+            threads.emplace_back([&, c]
+                                 {
+                std::uint64_t v;
+                while (running)
+                {
+                    bool got = c == 0 ? queue.Pop(&v) : !queue.Pop(static_cast<std::size_t>(32)).empty();
+                    if (!got)
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                } });
+        }
+        std::this_thread::sleep_for(duration);
+        running = false;
+        for (auto &t : threads)
+            t.join();
+        queue.EnableCapture(nullptr);
+
+        std::size_t records = 0;
+        for (auto &t : capture.Threads())
+            records += t->records.size();
+        if (!capture.Save(path))
+        {
+            printf("cannot write %s\n", path.c_str());
+            return 1;
+        }
+        printf("%s: %zu threads, %zu calls, %zu bytes of records\n", path.c_str(), capture.Threads().size(),
+               records, records * sizeof(CaptureRecord));
+        return 0;
+    }
+
+    /// @brief turn each batch pop followed by an unread of k elements into a
+    ///        batch pop of done - k, and the unread into a call moving nothing
+    void FoldUnread(std::vector<CaptureThread> &trace)
+    {
+        for (auto &t : trace)
+        {
+            CaptureRecord *pop = nullptr;
+            for (auto &r : t.records)
+            {
+                if (r.Op() == CaptureOp::PopBatch)
+                    pop = &r;
+                else if (r.Op() == CaptureOp::Unread && pop)
+                {
+                    auto k = std::min(r.done, pop->done);
+                    pop->done -= k;
+                    pop->op_req = (static_cast<std::uint32_t>(CaptureOp::PopBatch) << 24) | pop->done;
+                    r.done = 0;
+                    pop = nullptr;
+                }
+            }
+        }
+    }
+
+    template <typename Queue>
+    void Replay(const char *variant, const std::vector<CaptureThread> &trace, bool asap)
+    {
+        Queue queue;
+        HdrHistogram latency;
+        std::mutex merge;
+        std::atomic<std::uint64_t> moved{0};
+        std::atomic<bool> go{false};
+        std::int64_t start = 0; // published by the release store of go
+
+        std::vector<std::thread> threads;
+        for (auto &t : trace)
+        {
+            threads.emplace_back([&]
+                                 {
+                HdrHistogram local;
+                std::vector<std::uint64_t> batch;
+                std::uint64_t next = static_cast<std::uint64_t>(t.thread) << 40;
+                std::uint64_t done = 0;
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (auto &r : t.records)
+                {
+                    if (!asap)
+                    {
+                        auto at = start + static_cast<std::int64_t>(r.ts_ns);
+                        for (auto left = at - QueueClock::NowNs(); left > 0; left = at - QueueClock::NowNs())
+                        {
+                            if (left > 100000)
+                                std::this_thread::sleep_for(std::chrono::nanoseconds(left - 50000));
+                            else
+                                std::this_thread::yield();
+                        }
+                    }
+                    auto begin = QueueClock::NowNs();
+                    done += Ops<Queue>::Apply(queue, r, batch, next);
+                    local.Record(QueueClock::ElapsedNs(begin));
+                }
+                moved.fetch_add(done);
+                std::unique_lock<std::mutex> lck(merge);
+                latency.Add(local); });
+        }
+        start = QueueClock::NowNs() + 1000000;
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        auto wall = QueueClock::NowNs() - start;
+
+        std::uint64_t recorded = 0;
+        for (auto &t : trace)
+            for (auto &r : t.records)
+                recorded += r.done;
+        printf("%-10s %10.2f %10llu %8llu %8llu %8llu %10llu %12llu %12llu\n", variant, wall / 1e6,
+               static_cast<unsigned long long>(latency.Count()),
+               static_cast<unsigned long long>(latency.Quantile(0.5)), static_cast<unsigned long long>(latency.Quantile(0.99)),
+               static_cast<unsigned long long>(latency.Quantile(0.999)), static_cast<unsigned long long>(latency.Max()),
+               static_cast<unsigned long long>(moved.load()), static_cast<unsigned long long>(recorded));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (argc < 3 || (mode != "record" && mode != "replay"))
+    {
+        printf("usage: %s record <file> [ms]\n       %s replay <file> [ctq|ctq_hooks|fair|hybrid|all] [asap]\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (mode == "record")
+        return Record(argv[2], std::chrono::milliseconds(argc > 3 ? atoi(argv[3]) : 1000));
+
+    std::vector<CaptureThread> trace;
+    if (!QueueCapture::Load(argv[2], &trace))
+    {
+        printf("cannot read capture %s\n", argv[2]);
+        return 1;
+    }
+    FoldUnread(trace);
+    std::string variant = argc > 3 ? argv[3] : "all";
+    bool asap = argc > 4 && strcmp(argv[4], "asap") == 0;
+
+    std::size_t ops[static_cast<std::size_t>(CaptureOp::Count)] = {};
+    for (auto &t : trace)
+        for (auto &r : t.records)
+            if (r.Op() < CaptureOp::Count)
+                ops[static_cast<std::size_t>(r.Op())]++;
+    printf("%s: %zu threads,", argv[2], trace.size());
+    for (std::size_t i = 0; i < static_cast<std::size_t>(CaptureOp::Count); i++)
+        if (ops[i])
+            printf(" %s %zu", Jules::utils::CaptureOpName(static_cast<CaptureOp>(i)), ops[i]);
+    printf("\nreplay %s, call latency in ns\n", asap ? "back to back" : "at captured offsets");
+    printf("%-10s %10s %10s %8s %8s %8s %10s %12s %12s\n", "variant", "wall ms", "calls", "p50", "p99", "p99.9", "max",
+           "moved", "captured");
+
+    if (variant == "all" || variant == "ctq")
+        Replay<Jules::utils::CrossThreadQueue<std::uint64_t>>("ctq", trace, asap);
+    if (variant == "all" || variant == "ctq_hooks")
+        Replay<Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::CounterHooks>>("ctq_hooks", trace, asap);
+    if (variant == "all" || variant == "fair")
+        Replay<Jules::utils::FairQueue<std::uint64_t>>("fair", trace, asap);
+    if (variant == "all" || variant == "hybrid")
+        Replay<Jules::utils::HybridQueue<std::uint64_t>>("hybrid", trace, asap);
+    return 0;
+}
@@ -0,0 +1,330 @@
+// Throughput of each queue variant per producer/consumer scenario, with
+// heap allocations and hardware counters per element (one push + one pop);
+// the latter when perf_event_open is permitted. Before timing, a single
+// threaded parity check replays the same capacity script (SetMaxCount
+// shrinking a full queue, pushes past capacity, capacity 0) on the
+// variants that promise CrossThreadQueue semantics (hybrid, adaptive) and
+// compares sizes, contents and counters; a mismatch makes the program
+// exit 1. FairQueue drops per flow and is not compared. The same step
+// checks that QueueWatchdog reports a bounded queue with no consumer as
+// stalled although overflow keeps removing elements, and that the Chrome
+// trace export stays well-formed JSON with a long queue name.
+//
+// usage: bench_throughput [variant|all|parity] [elements]
+#include "../adaptive_queue.hpp"
+#include "../cross_thread_queue.hpp"
+#include "../fair_queue.hpp"
+#include "../hybrid_queue.hpp"
+#include "../queue_hooks.hpp"
+#include "../queue_trace.hpp"
+#include "../queue_watchdog.hpp"
+#define JULES_BENCH_ALLOC_COUNTER_IMPL
+#include "alloc_counter.hpp"
+#include "perf_counters.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using Jules::bench::AllocCounter;
+using Jules::bench::PerfCounters;
+using Jules::bench::PerfEvent;
+
+namespace
+{
+    constexpr std::size_t kCapacity = 4096;
+
+    struct Scenario
+    {
+        const char *name;
+        unsigned producers;
+        unsigned consumers;
+        std::size_t batch; ///< elements per consumer Pop call
+    };
+
+    const Scenario kScenarios[] = {
+        {"1p1c", 1, 1, 1},
+        {"1p1c_b32", 1, 1, 32},
+        {"2p2c", 2, 2, 1},
+        {"4p1c", 4, 1, 1},
+        {"4p4c_b32", 4, 4, 32},
+    };
+
+    /// @brief the calls that differ between queue types
+    template <typename Queue>
+    struct Ops
+    {
+        template <typename T>
+        static bool TryPush(Queue &q, const T &t) { return q.Try_Push(t); }
+    };
+
+    template <typename T>
+    struct Ops<Jules::utils::FairQueue<T>>
+    {
+        static bool TryPush(Jules::utils::FairQueue<T> &q, const T &t)
+        {
+            return q.Try_Push(Jules::utils::FairQueue<T>::CurrentProducer(), t);
+        }
+    };
+
+    template <typename Queue>
+    void Run(const char *variant, const Scenario &s, std::uint64_t elements, PerfCounters &perf)
+    {
+        Queue queue;
+        queue.SetMaxCount(kCapacity);
+        auto per_producer = elements / s.producers;
+        auto total = per_producer * s.producers;
+        std::atomic<std::uint64_t> consumed{0};
+        std::atomic<bool> go{false};
+
+        perf.Start();
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < s.producers; p++)
+        {
+            threads.emplace_back([&]
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::uint64_t i = 0; i < per_producer; i++)
+                {
+                    while (!Ops<Queue>::TryPush(queue, i))
+                        std::this_thread::yield();
+                } });
+        }
+        for (unsigned c = 0; c < s.consumers; c++)
+        {
+            threads.emplace_back([&]
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                std::uint64_t v;
+                while (consumed.load(std::memory_order_relaxed) < total)
+                {
+                    std::size_t n = 0;
+                    if (s.batch > 1)
+                        n = queue.Pop(s.batch).size();
+                    else
+                        n = queue.Pop(&v) ? 1 : 0;
+                    if (n)
+                        consumed.fetch_add(n, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                } });
+        }
+        // thread start-up allocations are done by now
+        auto allocs = AllocCounter::Instance().Take();
+        auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        perf.Stop();
+        allocs = AllocCounter::Instance().Take() - allocs;
+
+        printf("%-10s %-10s %10.2f %8.1f %9.4f %8.2f", variant, s.name, total / seconds / 1e6, seconds * 1e9 / total,
+               static_cast<double>(allocs.allocs) / total, static_cast<double>(allocs.bytes) / total);
+        for (std::size_t e = 0; e < PerfCounters::kEvents; e++)
+        {
+            auto ev = static_cast<PerfEvent>(e);
+            if (perf.Available(ev))
+                printf(" %10.3f", static_cast<double>(perf.Value(ev)) / total);
+            else
+                printf(" %10s", "n/a");
+        }
+        printf("\n");
+    }
+
+    /// @brief sizes, Try_Push results and contents seen through the capacity script
+    template <typename Queue>
+    std::vector<std::uint64_t> CapacityScript(Queue &q)
+    {
+        std::vector<std::uint64_t> seen;
+        auto drain = [&]
+        {
+            std::uint64_t v;
+            while (q.Pop(&v))
+                seen.push_back(v);
+            seen.push_back(~std::uint64_t(0));
+        };
+        for (std::uint64_t i = 0; i < 100; i++)
+            q.Push(i);
+        q.SetMaxCount(10);
+        seen.push_back(q.Size());
+        for (std::uint64_t i = 100; i < 150; i++)
+            q.Push(i);
+        seen.push_back(q.Size());
+        seen.push_back(Ops<Queue>::TryPush(q, std::uint64_t(999)));
+        drain();
+        for (std::uint64_t i = 200; i < 205; i++)
+            seen.push_back(Ops<Queue>::TryPush(q, i));
+        q.SetMaxCount(3);
+        drain();
+        q.SetMaxCount(0);
+        q.Push(1);
+        seen.push_back(q.Size());
+        seen.push_back(Ops<Queue>::TryPush(q, std::uint64_t(2)));
+        q.SetMaxCount(kCapacity);
+        for (std::uint64_t i = 300; i < 310; i++)
+            q.Push(i);
+        q.Clear();
+        seen.push_back(q.Size());
+        return seen;
+    }
+
+    /// @return true when the variant behaves like CrossThreadQueue
+    template <typename Queue>
+    bool Parity(const char *variant)
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t> reference;
+        Queue queue;
+        bool ok = CapacityScript(queue) == CapacityScript(reference);
+        printf("%-10s capacity parity with ctq: %s\n", variant, ok ? "ok" : "FAIL");
+        return ok;
+    }
+
+    template <typename Queue>
+    bool CounterParity(const char *variant)
+    {
+        Jules::utils::CrossThreadQueue<std::uint64_t> reference;
+        Queue queue;
+        CapacityScript(reference);
+        CapacityScript(queue);
+        auto &a = reference.Counters();
+        auto &b = queue.Counters();
+        bool ok = a.pushed.Load() == b.pushed.Load() && a.popped.Load() == b.popped.Load() &&
+                  a.dropped.Load() == b.dropped.Load();
+        printf("%-10s counter parity with ctq: %s\n", variant, ok ? "ok" : "FAIL");
+        return ok;
+    }
+
+    /// @return true when a full bounded queue without consumer is reported
+    ///         stalled and dropping, and a drained one is not
+    bool WatchdogCheck()
+    {
+        using std::chrono::milliseconds;
+        Jules::utils::CrossThreadQueue<std::uint64_t> dead, live;
+        dead.SetMaxCount(10);
+        live.SetMaxCount(10);
+        Jules::utils::QueueWatchdog watchdog;
+        watchdog.Watch("dead", dead, milliseconds(20));
+        watchdog.Watch("live", live, milliseconds(20));
+        std::uint64_t v;
+        auto end = std::chrono::steady_clock::now() + milliseconds(100);
+        for (std::uint64_t i = 0; std::chrono::steady_clock::now() < end; i++)
+        {
+            for (int k = 0; k < 20; k++)
+                dead.Push(i);
+            while (live.Pop(&v))
+                ;
+            live.Push(i); // non-empty between pops, never past capacity
+            watchdog.Sample();
+            std::this_thread::sleep_for(milliseconds(2));
+        }
+        bool ok = true;
+        for (auto &h : watchdog.Snapshot())
+        {
+            bool want = h.name == "dead";
+            ok &= h.stalled == want && h.dropping == want;
+        }
+        ok &= watchdog.StallCount() == 1;
+        printf("%-10s watchdog stall under overflow: %s\n", "ctq", ok ? "ok" : "FAIL");
+        return ok;
+    }
+
+    /// @brief brackets balance outside strings, strings end, no raw control chars
+    bool WellFormedJson(const std::string &json)
+    {
+        int depth = 0;
+        bool in_string = false;
+        for (std::size_t i = 0; i < json.size(); i++)
+        {
+            char ch = json[i];
+            if (in_string)
+            {
+                if (static_cast<unsigned char>(ch) < 0x20)
+                    return false;
+                if (ch == '\\')
+                    i++;
+                else if (ch == '"')
+                    in_string = false;
+            }
+            else if (ch == '"')
+                in_string = true;
+            else if (ch == '{' || ch == '[')
+                depth++;
+            else if ((ch == '}' || ch == ']') && --depth < 0)
+                return false;
+        }
+        return depth == 0 && !in_string;
+    }
+
+    /// @return true when ChromeJson keeps a 2000 character queue name intact
+    bool TraceExportCheck()
+    {
+        auto &recorder = Jules::utils::TraceRecorder::Instance();
+        Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::TraceHooks> queue;
+        std::string name(2000, 'q');
+        name += "\"\\end";
+        recorder.NameQueue(&queue, name);
+        recorder.Start(64);
+        std::uint64_t v;
+        queue.Push(1);
+        queue.Pop(&v);
+        recorder.Stop();
+        auto json = recorder.ChromeJson();
+        recorder.Reset();
+        bool ok = WellFormedJson(json) && json.find(std::string(2000, 'q') + "\\\"\\\\end\"") != std::string::npos;
+        printf("%-10s trace export with long name: %s\n", "ctq_trace", ok ? "ok" : "FAIL");
+        return ok;
+    }
+
+    template <typename Queue>
+    void RunAll(const char *variant, std::uint64_t elements, PerfCounters &perf)
+    {
+        for (auto &s : kScenarios)
+            Run<Queue>(variant, s, elements, perf);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string variant = argc > 1 ? argv[1] : "all";
+    std::uint64_t elements = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000000;
+
+    if (variant == "all" || variant == "parity")
+    {
+        bool ok = Parity<Jules::utils::HybridQueue<std::uint64_t>>("hybrid");
+        ok &= CounterParity<Jules::utils::HybridQueue<std::uint64_t>>("hybrid");
+        ok &= Parity<Jules::utils::AdaptiveQueue<std::uint64_t>>("adaptive");
+        ok &= WatchdogCheck();
+        ok &= TraceExportCheck();
+        if (!ok)
+            return 1;
+        if (variant == "parity")
+            return 0;
+    }
+
+    PerfCounters perf;
+    if (!perf.Any())
+        printf("perf counters unavailable (check /proc/sys/kernel/perf_event_paranoid), timing only\n");
+    printf("%-10s %-10s %10s %8s %9s %8s", "variant", "scenario", "Melem/s", "ns/elem", "allocs", "bytes");
+    for (std::size_t e = 0; e < PerfCounters::kEvents; e++)
+        printf(" %10s", Jules::bench::PerfEventName(static_cast<PerfEvent>(e)));
+    printf("\n");
+
+    if (variant == "all" || variant == "ctq")
+        RunAll<Jules::utils::CrossThreadQueue<std::uint64_t>>("ctq", elements, perf);
+    if (variant == "all" || variant == "ctq_hooks")
+        RunAll<Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::CounterHooks>>("ctq_hooks", elements, perf);
+    if (variant == "all" || variant == "fair")
+        RunAll<Jules::utils::FairQueue<std::uint64_t>>("fair", elements, perf);
+    if (variant == "all" || variant == "hybrid")
+        RunAll<Jules::utils::HybridQueue<std::uint64_t>>("hybrid", elements, perf);
+    if (variant == "all" || variant == "adaptive")
+        RunAll<Jules::utils::AdaptiveQueue<std::uint64_t>>("adaptive", elements, perf);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Token-less calls against ProducerToken/ConsumerToken on CrossThreadQueue,
+// per producer/consumer scenario and token batch size. At batch 1 tokens
+// cost about the same as token-less calls; the gain comes only from larger
+// batches, which take one lock acquisition per batch instead of one per
+// element.
+//
+// usage: bench_tokens [elements]
+#include "../cross_thread_queue.hpp"
+#include "../queue_hooks.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+    struct Scenario
+    {
+        const char *name;
+        unsigned producers;
+        unsigned consumers;
+    };
+
+    const Scenario kScenarios[] = {
+        {"1p1c", 1, 1},
+        {"2p2c", 2, 2},
+        {"4p4c", 4, 4},
+    };
+
+    /// @param batch token batch size, 0 for token-less calls
+    template <typename Queue>
+    double Run(const Scenario &s, std::size_t batch, std::uint64_t elements)
+    {
+        Queue queue;
+        queue.SetMaxCount(4096);
+        auto per_producer = elements / s.producers;
+        auto total = per_producer * s.producers;
+        std::atomic<std::uint64_t> consumed{0};
+        std::atomic<bool> go{false};
+
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < s.producers; p++)
+        {
+            threads.emplace_back([&]
+                                 {
+                auto token = queue.GetProducerToken(batch ? batch : 1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::uint64_t i = 0; i < per_producer; i++)
+                {
+                    if (batch)
+                        while (!queue.Try_Push(token, i))
+                            std::this_thread::yield();
+                    else
+                        while (!queue.Try_Push(i))
+                            std::this_thread::yield();
+                }
+                queue.Flush(token); });
+        }
+        for (unsigned c = 0; c < s.consumers; c++)
+        {
+            threads.emplace_back([&]
+                                 {
+                auto token = queue.GetConsumerToken(batch ? batch : 1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                std::uint64_t v;
+                while (consumed.load(std::memory_order_relaxed) < total)
+                {
+                    if (batch ? queue.Pop(token, &v) : queue.Pop(&v))
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                } });
+        }
+        auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / total;
+    }
+
+    template <typename Queue>
+    void RunAll(const char *variant, std::uint64_t elements)
+    {
+        const std::size_t batches[] = {0, 1, 8, 32};
+        for (auto &s : kScenarios)
+        {
+            printf("%-10s %-6s", variant, s.name);
+            for (auto b : batches)
+                printf(" %10.1f", Run<Queue>(s, b, elements));
+            printf("\n");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::uint64_t elements = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+    printf("ns per element (one push + one pop)\n%-10s %-6s %10s %10s %10s %10s\n", "variant", "case", "no token",
+           "batch 1", "batch 8", "batch 32");
+    RunAll<Jules::utils::CrossThreadQueue<std::uint64_t>>("ctq", elements);
+    RunAll<Jules::utils::CrossThreadQueue<std::uint64_t, Jules::utils::CounterHooks>>("ctq_hooks", elements);
+    return 0;
+}
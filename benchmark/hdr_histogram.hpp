@@ -0,0 +1,118 @@
+/*
+ * ---------------------------------------
+ * File: hdr_histogram.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - High dynamic range histogram for benchmark latencies
+ */
+#ifndef _JULES_HDR_HISTOGRAM_HPP_
+#define _JULES_HDR_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Jules::bench
+{
+    /// @brief log-linear histogram with 3 significant decimal digits
+    /// @note same layout as HdrHistogram: each power of two range is split
+    ///       into 1024 linear sub-buckets, so the recorded value is kept
+    ///       within 0.1% over the whole range. Single writer; merge per-thread
+    ///       histograms with Add.
+    class HdrHistogram
+    {
+    public:
+        static constexpr unsigned kSubBits = 11; ///< 2048 sub-buckets, 1024 per half range
+
+        /// @param highest largest trackable value, larger ones are clamped
+        explicit HdrHistogram(std::uint64_t highest = std::uint64_t(1) << 40)
+            : highest_(highest)
+        {
+            counts_.resize(IndexOf(highest) + 1);
+        }
+
+        void Record(std::uint64_t v, std::uint64_t count = 1)
+        {
+            v = std::min(v, highest_);
+            counts_[IndexOf(v)] += count;
+            total_ += count;
+            sum_ += v * count;
+            min_ = std::min(min_, v);
+            max_ = std::max(max_, v);
+        }
+
+        /// @brief merge another histogram of the same range
+        void Add(const HdrHistogram &other)
+        {
+            for (std::size_t i = 0; i < counts_.size() && i < other.counts_.size(); i++)
+                counts_[i] += other.counts_[i];
+            total_ += other.total_;
+            sum_ += other.sum_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+
+        void Reset()
+        {
+            std::fill(counts_.begin(), counts_.end(), 0);
+            total_ = sum_ = max_ = 0;
+            min_ = UINT64_MAX;
+        }
+
+        std::uint64_t Count() const { return total_; }
+        std::uint64_t Max() const { return max_; }
+        std::uint64_t Min() const { return total_ ? min_ : 0; }
+        double Mean() const { return total_ ? static_cast<double>(sum_) / static_cast<double>(total_) : 0.0; }
+
+        /// @brief value at quantile q in [0, 1], highest value equivalent to its bucket
+        std::uint64_t Quantile(double q) const
+        {
+            if (total_ == 0)
+                return 0;
+            auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total_ - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < counts_.size(); i++)
+            {
+                seen += counts_[i];
+                if (seen >= rank)
+                    return std::min(HighestEquivalent(i), max_);
+            }
+            return max_;
+        }
+
+    private:
+        static constexpr std::uint64_t kSubCount = std::uint64_t(1) << kSubBits;
+        static constexpr std::uint64_t kHalf = kSubCount / 2;
+
+        static std::size_t IndexOf(std::uint64_t v)
+        {
+            int bucket = 64 - __builtin_clzll(v | (kSubCount - 1)) - static_cast<int>(kSubBits);
+            auto sub = v >> bucket;
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(bucket) << (kSubBits - 1)) + sub);
+        }
+
+        static std::uint64_t HighestEquivalent(std::size_t index)
+        {
+            std::uint64_t bucket = index >> (kSubBits - 1);
+            std::uint64_t sub = index & (kHalf - 1);
+            if (bucket == 0)
+                return index;
+            bucket--;
+            return ((sub + kHalf) << bucket) + (std::uint64_t(1) << bucket) - 1;
+        }
+
+        std::vector<std::uint64_t> counts_;
+        std::uint64_t highest_;
+        std::uint64_t total_ = 0;
+        std::uint64_t sum_ = 0;
+        std::uint64_t min_ = UINT64_MAX;
+        std::uint64_t max_ = 0;
+    };
+
+} // ! namespace Jules::bench
+
+#endif
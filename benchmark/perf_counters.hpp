@@ -0,0 +1,171 @@
+/*
+ * ---------------------------------------
+ * File: perf_counters.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Hardware/software counters around a benchmark scenario (Linux perf_event_open)
+ */
+#ifndef _JULES_PERF_COUNTERS_HPP_
+#define _JULES_PERF_COUNTERS_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Jules::bench
+{
+    enum class PerfEvent : std::size_t
+    {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        LlcMisses,
+        ContextSwitches,
+        Count
+    };
+
+    inline const char *PerfEventName(PerfEvent e)
+    {
+        static const char *names[] = {"cycles", "instr", "cache-miss", "llc-miss", "ctx-sw"};
+        return e < PerfEvent::Count ? names[static_cast<std::size_t>(e)] : "unknown";
+    }
+
+    /// @brief counts events of the calling thread and of threads it creates
+    ///        between Start and Stop
+    /// @note hardware events count user space only, so they work with
+    ///       perf_event_paranoid <= 2.
+    ///       Counters that cannot be opened (no PMU in a VM, paranoid 3,
+    ///       seccomp, non-Linux) read as unavailable instead of failing;
+    ///       child threads are only accounted once they have exited, so
+    ///       join workers before Stop.
+    class PerfCounters
+    {
+    public:
+        static constexpr std::size_t kEvents = static_cast<std::size_t>(PerfEvent::Count);
+
+        PerfCounters()
+        {
+            for (auto &fd : fds_)
+                fd = -1;
+#ifdef __linux__
+            fds_[0] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            fds_[1] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            fds_[2] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            fds_[3] = Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+            fds_[4] = Open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+#endif
+        }
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        ~PerfCounters()
+        {
+#ifdef __linux__
+            for (auto fd : fds_)
+                if (fd >= 0)
+                    close(fd);
+#endif
+        }
+
+        /// @brief true if at least one counter could be opened
+        bool Any() const
+        {
+            for (auto fd : fds_)
+                if (fd >= 0)
+                    return true;
+            return false;
+        }
+
+        bool Available(PerfEvent e) const { return fds_[static_cast<std::size_t>(e)] >= 0; }
+
+        /// @brief enable all counters and take their starting values
+        void Start()
+        {
+#ifdef __linux__
+            for (std::size_t i = 0; i < kEvents; i++)
+            {
+                if (fds_[i] < 0)
+                    continue;
+                ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+                Read(fds_[i], base_[i]);
+            }
+#endif
+        }
+
+        /// @brief disable all counters and latch the difference since Start
+        /// @note RESET does not clear counts folded in from exited threads,
+        ///       hence the baseline instead of resetting
+        void Stop()
+        {
+#ifdef __linux__
+            for (std::size_t i = 0; i < kEvents; i++)
+            {
+                values_[i] = 0;
+                if (fds_[i] < 0)
+                    continue;
+                std::uint64_t now[3];
+                if (!Read(fds_[i], now))
+                    continue;
+                ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+                // value, time enabled, time running; scaled when multiplexed
+                auto value = now[0] - base_[i][0];
+                auto enabled = now[1] - base_[i][1];
+                auto running = now[2] - base_[i][2];
+                values_[i] = running && running < enabled
+                                 ? static_cast<std::uint64_t>(static_cast<double>(value) * enabled / running)
+                                 : value;
+            }
+#endif
+        }
+
+        /// @brief value latched by the last Stop, 0 when unavailable
+        std::uint64_t Value(PerfEvent e) const { return values_[static_cast<std::size_t>(e)]; }
+
+    private:
+#ifdef __linux__
+        static int Open(std::uint32_t type, std::uint64_t config)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            // context switches happen in the kernel, count them there if allowed
+            if (type == PERF_TYPE_SOFTWARE)
+            {
+                auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+                if (fd >= 0)
+                    return fd;
+            }
+            attr.exclude_kernel = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        static bool Read(int fd, std::uint64_t (&out)[3])
+        {
+            out[0] = out[1] = out[2] = 0;
+            return read(fd, out, sizeof(out)) == static_cast<ssize_t>(sizeof(out));
+        }
+#endif
+
+        int fds_[kEvents];
+        std::uint64_t base_[kEvents][3] = {};
+        std::uint64_t values_[kEvents] = {};
+    };
+
+} // ! namespace Jules::bench
+
+#endif
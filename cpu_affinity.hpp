@@ -0,0 +1,242 @@
+/*
+ * ---------------------------------------
+ * File: cpu_affinity.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - CPU topology from /sys/devices/system/cpu and thread pinning
+ * - Linux only, other systems see no CPUs and pinning fails
+ */
+#ifndef _JULES_CPU_AFFINITY_HPP_
+#define _JULES_CPU_AFFINITY_HPP_
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Jules::utils
+{
+    /// @brief where two threads run relative to each other
+    enum class Placement
+    {
+        SameCpu,     ///< one logical CPU, threads time-share
+        SmtSiblings, ///< two hardware threads of one core
+        SameLlc,     ///< different cores sharing the last level cache
+        CrossLlc,    ///< same package, different last level caches
+        CrossSocket, ///< different packages
+        Count
+    };
+
+    inline const char *PlacementName(Placement p)
+    {
+        static const char *names[] = {"same_cpu", "smt_siblings", "same_llc", "cross_llc", "cross_socket"};
+        return p < Placement::Count ? names[static_cast<std::size_t>(p)] : "unknown";
+    }
+
+    /// @brief one online logical CPU
+    struct CpuInfo
+    {
+        int cpu = 0;
+        int core = 0;    ///< core_id, unique within a package
+        int package = 0; ///< physical_package_id
+        int llc = -1;    ///< first CPU sharing the last level cache, -1 if unknown
+    };
+
+    /// @brief online CPUs as described by sysfs
+    class CpuTopology
+    {
+    public:
+        /// @brief read /sys/devices/system/cpu, empty when unavailable
+        /// @param allowed_only keep only CPUs in the calling thread's affinity
+        ///        mask (cpuset, taskset, container limits), so every CPU listed
+        ///        can be pinned to; read it before pinning the calling thread
+        static CpuTopology Read(bool allowed_only = true)
+        {
+            CpuTopology t;
+            std::string online;
+            if (!ReadLine("/sys/devices/system/cpu/online", &online))
+                return t;
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (allowed_only && sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+                allowed_only = false; // mask unknown, keep every CPU
+            for (auto cpu : ParseList(online))
+            {
+                if (allowed_only && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)))
+                    continue;
+                std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+                CpuInfo info;
+                info.cpu = cpu;
+                info.core = ReadInt(base + "/topology/core_id", cpu);
+                info.package = ReadInt(base + "/topology/physical_package_id", 0);
+                // highest level cache index is the LLC
+                int level = 0;
+                for (int i = 0;; i++)
+                {
+                    std::string index = base + "/cache/index" + std::to_string(i);
+                    int l = ReadInt(index + "/level", -1);
+                    if (l < 0)
+                        break;
+                    std::string shared;
+                    if (l >= level && ReadLine(index + "/shared_cpu_list", &shared))
+                    {
+                        auto cpus = ParseList(shared);
+                        if (!cpus.empty())
+                        {
+                            level = l;
+                            info.llc = cpus.front();
+                        }
+                    }
+                }
+                t.cpus_.push_back(info);
+            }
+            return t;
+        }
+
+        const std::vector<CpuInfo> &Cpus() const { return cpus_; }
+
+        /// @brief find two CPUs with the given relation
+        /// @param placement wanted relation
+        /// @param a first CPU
+        /// @param b second CPU, equals a for SameCpu
+        /// @return false if this machine has no such pair
+        bool FindPair(Placement placement, int *a, int *b) const
+        {
+            for (auto &x : cpus_)
+            {
+                if (placement == Placement::SameCpu)
+                {
+                    *a = *b = x.cpu;
+                    return true;
+                }
+                for (auto &y : cpus_)
+                {
+                    if (y.cpu == x.cpu || !Matches(placement, x, y))
+                        continue;
+                    *a = x.cpu;
+                    *b = y.cpu;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// @brief parse a sysfs CPU list such as "0-3,8,10-11"
+        static std::vector<int> ParseList(const std::string &list)
+        {
+            std::vector<int> cpus;
+            std::stringstream ss(list);
+            std::string range;
+            while (std::getline(ss, range, ','))
+            {
+                int first = 0, last = 0;
+                auto n = sscanf(range.c_str(), "%d-%d", &first, &last);
+                if (n < 1)
+                    continue;
+                if (n == 1)
+                    last = first;
+                for (int c = first; c <= last; c++)
+                    cpus.push_back(c);
+            }
+            return cpus;
+        }
+
+    private:
+        static bool Matches(Placement p, const CpuInfo &x, const CpuInfo &y)
+        {
+            bool same_core = x.package == y.package && x.core == y.core;
+            bool same_llc = x.llc >= 0 && x.llc == y.llc;
+            switch (p)
+            {
+            case Placement::SmtSiblings:
+                return same_core;
+            case Placement::SameLlc:
+                return !same_core && same_llc;
+            case Placement::CrossLlc:
+                return x.package == y.package && x.llc >= 0 && y.llc >= 0 && !same_llc;
+            case Placement::CrossSocket:
+                return x.package != y.package;
+            default:
+                return false;
+            }
+        }
+
+        static bool ReadLine(const std::string &path, std::string *out)
+        {
+            std::ifstream f(path);
+            return f && std::getline(f, *out);
+        }
+
+        static int ReadInt(const std::string &path, int fallback)
+        {
+            std::string s;
+            if (!ReadLine(path, &s))
+                return fallback;
+            try
+            {
+                return std::stoi(s);
+            }
+            catch (...)
+            {
+                return fallback;
+            }
+        }
+
+        std::vector<CpuInfo> cpus_;
+    };
+
+#ifdef __linux__
+    /// @brief pin a thread to one logical CPU
+    /// @param thread native handle, e.g. std::thread::native_handle()
+    /// @param cpu logical CPU number
+    /// @return true for pinned
+    inline bool PinThread(pthread_t thread, int cpu)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+    }
+
+    inline bool PinThread(std::thread &thread, int cpu)
+    {
+        return PinThread(thread.native_handle(), cpu);
+    }
+
+    /// @brief pin the calling thread, e.g. first thing in a pipeline stage
+    inline bool PinCurrentThread(int cpu)
+    {
+        return PinThread(pthread_self(), cpu);
+    }
+
+    /// @brief undo pinning of the calling thread: allow every online CPU
+    ///        (the kernel still confines it to its cpuset)
+    inline bool UnpinCurrentThread()
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto &c : CpuTopology::Read(false).Cpus())
+            if (c.cpu < CPU_SETSIZE)
+                CPU_SET(c.cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#else
+    inline bool PinThread(std::thread &, int) { return false; }
+    inline bool PinCurrentThread(int) { return false; }
+    inline bool UnpinCurrentThread() { return false; }
+#endif
+
+} // ! namespace Jules::utils
+
+#endif
@@ -11,17 +11,53 @@
 #ifndef _JULES_CROSS_THREAD_QUEUE_HPP_
 #define _JULES_CROSS_THREAD_QUEUE_HPP_
 
+#include <algorithm>
 #include <deque>
 #include <vector>
 #include <mutex>
 #include <limits>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "token_bucket.hpp"
+#include "queue_clock.hpp"
+#include "queue_stats.hpp"
+#include "queue_trace.hpp"
+#include "queue_hooks.hpp"
+#include "queue_probes.hpp"
+#include "queue_capture.hpp"
 using namespace std::chrono_literals;
 
 namespace Jules::utils
 {
-    template <typename T>
+    /// @brief metadata kept next to each element in envelope mode
+    struct Envelope
+    {
+        std::int64_t enqueue_ns = 0; ///< QueueClock time of push, in ns
+        std::uint64_t sequence = 0;  ///< push order within the queue, from 0
+        std::uint32_t producer = 0;  ///< pushing thread, see CurrentProducerId
+    };
+
+    /// @brief small process wide id of the calling thread, from 1
+    inline std::uint32_t CurrentProducerId()
+    {
+        static std::atomic<std::uint32_t> next{1};
+        static thread_local std::uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    /// @tparam T element type
+    /// @tparam Hooks compile-time instrumentation policy, see queue_hooks.hpp
+    /// @tparam Lock mutex type, Lockable; e.g. PiMutex (pi_mutex.hpp) for
+    ///         priority inheritance. Anything other than std::mutex waits on
+    ///         std::condition_variable_any, whose internal std::mutex is
+    ///         held only around the wait itself
+    template <typename T, typename Hooks = NoHooks, typename Lock = std::mutex>
     class CrossThreadQueue
     {
     public:
@@ -79,13 +115,42 @@ namespace Jules::utils
         /// @return
         auto Pop(std::size_t num = 1);
 
+        /// @brief try to pop element with its envelope
+        /// @param t pointer to poped element
+        /// @param env pointer to its metadata, zeroed unless envelope mode is on
+        /// @return true for poped false for failed
+        bool Pop(T *t, Envelope *env);
+
+        /// @brief pop up to num elements with their envelopes
+        /// @param num max count of elements
+        /// @param envs receives one envelope per poped element
+        /// @return poped elements
+        std::vector<T> Pop(std::size_t num, std::vector<Envelope> *envs);
+
         /// @brief
         /// @warning potential risk of deadlock, better not use!
         /// @param t
         /// @return
         [[deprecated("Potential risk of deadlock, better not use!")]] bool Pop_Must(T *t);
 
-        /// @brief clear the queue
+        /// @brief pop element paced by token bucket
+        /// @note blocks until both an element and a token are available
+        /// @param bucket token bucket, may be shared by several consumers
+        /// @param t pointer to poped element
+        /// @param timeout max time to wait
+        /// @return true for poped false for timeout
+        bool Pop_Limited(TokenBucket &bucket, T *t, std::chrono::milliseconds timeout);
+
+        /// @brief pop up to num elements paced by token bucket
+        /// @note blocks until at least one element and one token are available,
+        ///       takes as many elements as there are tokens
+        /// @param bucket token bucket, may be shared by several consumers
+        /// @param num max count of elements
+        /// @param timeout max time to wait
+        /// @return poped elements, empty for timeout
+        std::vector<T> Pop_Limited(TokenBucket &bucket, std::size_t num, std::chrono::milliseconds timeout);
+
+        /// @brief clear the queue, each element counts as one drop
         void Clear();
 
         /// @brief erase element from value
@@ -98,165 +163,821 @@ namespace Jules::utils
         /// @param duration time duration in millisecond
         static void Sleep(size_t duration);
 
+        /// @brief element counters, readable without locking the queue
+        /// @return counters of this queue
+        const QueueCounters &Counters() const { return counters_; }
+
+        /// @brief sojourn time histogram, filled while latency tracking is on
+        /// @return latency histogram of this queue
+        const LatencyHistogram &Latency() const { return latency_; }
+
+        /// @brief turn per-element sojourn time tracking on or off
+        /// @note costs one clock read per push and per pop while enabled
+        /// @param enable true for tracking
+        void EnableLatency(bool enable);
+
+        /// @brief keep enqueue time, producer id and sequence number per element
+        /// @note 24 bytes per queued element, stored in deque blocks so there is
+        ///       no allocation per element; elements already queued get the
+        ///       current time and producer 0
+        /// @param enable true for envelope mode
+        void EnableEnvelope(bool enable);
+
+        /// @brief lock wait/hold histograms per operation, null until profiling was enabled
+        /// @return lock profile of this queue
+        const LockProfile *LockStats() const { return lock_profile_.load(std::memory_order_acquire); }
+
+        /// @brief profile mutex wait and hold time of Push, Pop, Erase and Clear
+        /// @note unsampled operations pay one extra load and branch
+        /// @param sample_every profile one in every N operations per thread, 0 for off
+        void EnableLockProfiling(std::uint32_t sample_every);
+
+        /// @brief record push/pop/drop of this queue into TraceRecorder while it is started
+        /// @param enable true for tracing
+        /// @param name queue name shown in the trace
+        void EnableTracing(bool enable, const std::string &name = {});
+
+        /// @brief record every call on this queue into capture, for replay
+        /// @note capture must outlive the attachment; null detaches
+        /// @param capture capture to append to
+        void EnableCapture(QueueCapture *capture);
+
+        /// @brief instance of the hooks policy, e.g. to read CounterHooks
+        /// @return hooks of this queue
+        Hooks &GetHooks() { return hooks_; }
+        const Hooks &GetHooks() const { return hooks_; }
+
+        /// @brief push handle for one producer thread, from GetProducerToken
+        /// @note caches the producer id of the thread that created it and
+        ///       buffers up to batch elements, which reach
+        ///       the queue in one lock acquisition when the buffer is full,
+        ///       on Flush or when the token is destroyed. Buffered elements
+        ///       are not visible to consumers, Size or capacity checks yet.
+        ///       Use from one thread at a time; must not outlive the queue.
+        class ProducerToken
+        {
+        public:
+            ProducerToken(ProducerToken &&other) noexcept
+                : queue_(other.queue_), batch_(other.batch_), producer_(other.producer_), buffer_(std::move(other.buffer_))
+            {
+                other.queue_ = nullptr;
+            }
+            ProducerToken(const ProducerToken &) = delete;
+            ProducerToken &operator=(const ProducerToken &) = delete;
+            ProducerToken &operator=(ProducerToken &&) = delete;
+            ~ProducerToken()
+            {
+                if (queue_)
+                    queue_->Flush(*this);
+            }
+
+            /// @brief elements buffered, not yet in the queue
+            std::size_t Pending() const { return buffer_.size(); }
+
+        private:
+            friend class CrossThreadQueue;
+            ProducerToken(CrossThreadQueue *queue, std::size_t batch)
+                : queue_(queue), batch_(std::max<std::size_t>(batch, 1)), producer_(CurrentProducerId())
+            {
+                buffer_.reserve(batch_);
+            }
+
+            CrossThreadQueue *queue_;
+            std::size_t batch_;
+            std::uint32_t producer_;
+            std::vector<T> buffer_;
+        };
+
+        /// @brief pop handle for one consumer thread, from GetConsumerToken
+        /// @note takes up to batch elements per lock acquisition, handing
+        ///       them out from a local cache. Cached elements count as popped
+        ///       and are out of reach of other consumers, Erase and Clear.
+        ///       When the token is destroyed unread ones are pushed again,
+        ///       ahead of the queued elements and counted, hooked and traced
+        ///       like any push, captured as an unread; if that overflows the capacity they
+        ///       are the oldest and are dropped first. Use from one thread at
+        ///       a time; must not outlive the queue.
+        class ConsumerToken
+        {
+        public:
+            ConsumerToken(ConsumerToken &&other) noexcept
+                : queue_(other.queue_), batch_(other.batch_), cache_(std::move(other.cache_)), next_(other.next_)
+            {
+                other.queue_ = nullptr;
+            }
+            ConsumerToken(const ConsumerToken &) = delete;
+            ConsumerToken &operator=(const ConsumerToken &) = delete;
+            ConsumerToken &operator=(ConsumerToken &&) = delete;
+            ~ConsumerToken()
+            {
+                if (queue_)
+                    queue_->Unread(*this);
+            }
+
+            /// @brief elements cached, taken from the queue but not yet read
+            std::size_t Cached() const { return cache_.size() - next_; }
+
+        private:
+            friend class CrossThreadQueue;
+            ConsumerToken(CrossThreadQueue *queue, std::size_t batch)
+                : queue_(queue), batch_(std::max<std::size_t>(batch, 1))
+            {
+                cache_.reserve(batch_);
+            }
+
+            CrossThreadQueue *queue_;
+            std::size_t batch_;
+            std::vector<T> cache_;
+            std::size_t next_ = 0; ///< first unread element of cache_
+        };
+
+        /// @brief handle for the calling producer thread
+        /// @param batch elements buffered before they are pushed, 1 for none
+        ProducerToken GetProducerToken(std::size_t batch = 32) { return ProducerToken(this, batch); }
+
+        /// @brief handle for the calling consumer thread
+        /// @param batch elements taken from the queue per refill, 1 for none
+        ConsumerToken GetConsumerToken(std::size_t batch = 32) { return ConsumerToken(this, batch); }
+
+        /// @brief buffer element in the token, pushed like Push(ts) once batch are buffered
+        /// @param token producer token of this queue
+        /// @param t element
+        void Push(ProducerToken &token, const T &t);
+
+        /// @brief buffer element in the token; a full buffer is pushed as far
+        ///        as capacity allows, without dropping
+        /// @param token producer token of this queue
+        /// @param t element
+        /// @return true for buffered false for buffer and queue full
+        bool Try_Push(ProducerToken &token, const T &t);
+
+        /// @brief push everything buffered in the token, dropping the oldest when full
+        /// @param token producer token of this queue
+        void Flush(ProducerToken &token);
+
+        /// @brief pop element through the token's cache, refilled in one lock acquisition
+        /// @param token consumer token of this queue
+        /// @param t pointer to poped element
+        /// @return true for poped false for empty
+        bool Pop(ConsumerToken &token, T *t);
+
     private:
+        /// @brief scoped queue lock timing acquisition and hold when sampled
+        class ProfiledLock
+        {
+        public:
+            ProfiledLock(CrossThreadQueue &q, QueueOp op);
+            ~ProfiledLock();
+
+        private:
+            std::unique_lock<Lock> lck_;
+            LockProfile *profile_ = nullptr;
+            std::size_t op_;
+            std::int64_t acquired_ns_ = 0;
+        };
+
+        void OnPushed(std::size_t n)
+        {
+            counters_.pushed.Add(n);
+            if (trace_on_)
+                TraceRecorder::Instance().Record(TraceOp::Push, this, queue_.size());
+            hooks_.OnPush(this, queue_.size());
+            JULES_CTQ_PROBE3(push, this, queue_.size(), n);
+        }
+        void OnPopped(std::size_t n)
+        {
+            counters_.popped.Add(n);
+            if (trace_on_)
+                TraceRecorder::Instance().Record(TraceOp::Pop, this, queue_.size());
+            hooks_.OnPop(this, queue_.size());
+            JULES_CTQ_PROBE3(pop, this, queue_.size(), n);
+        }
+        void OnDropped(std::size_t n)
+        {
+            counters_.dropped.Add(n);
+            if (trace_on_)
+                TraceRecorder::Instance().Record(TraceOp::Drop, this, queue_.size());
+            hooks_.OnDrop(this, queue_.size());
+            JULES_CTQ_PROBE3(drop, this, queue_.size(), n);
+        }
+        void Capture(CaptureOp op, std::size_t requested, std::size_t done)
+        {
+            if (capture_)
+                capture_->Record(op, requested, done);
+        }
+        void OnWaitBegin()
+        {
+            hooks_.OnWaitBegin(this);
+            JULES_CTQ_PROBE2(wait__begin, this, queue_.size());
+        }
+        void OnWaitEnd()
+        {
+            hooks_.OnWaitEnd(this);
+            JULES_CTQ_PROBE2(wait__end, this, queue_.size());
+        }
+
+        /// @param producer envelope producer id, 0 to look up the calling thread's
+        void PushBack(const T &t, std::uint32_t producer = 0);
+        void PopFront(T *t, Envelope *env = nullptr);
+        /// @brief single element pushes behind Try_Push and Push, with the
+        ///        producer id given by the caller or a token
+        bool TryPushOne(const T &t, std::uint32_t producer);
+        void PushOne(const T &t, std::uint32_t producer);
+        /// @brief push the first n buffered elements of token, caller holds the lock
+        void PushToken(ProducerToken &token, std::size_t n, bool drop);
+        /// @brief push unread cached elements of token again, at the front
+        void Unread(ConsumerToken &token);
+        void SetMeta(bool latency, bool envelope);
+        void DropFront();
+        void EraseAt(std::size_t k);
+
+        bool WaitLimited(std::unique_lock<Lock> &lck, TokenBucket &bucket, std::size_t num,
+                         std::chrono::steady_clock::time_point deadline, std::size_t *tokens);
+
         std::deque<T> queue_;
-        std::mutex mutex_;
+        Lock mutex_;
+        std::conditional_t<std::is_same<Lock, std::mutex>::value, std::condition_variable, std::condition_variable_any> cond_;
         std::size_t max_count_ = std::numeric_limits<size_t>::max();
+        QueueCounters counters_;
+        LatencyHistogram latency_;
+        std::deque<Envelope> meta_; ///< one per element while meta_on_, same order as queue_
+        bool meta_on_ = false;
+        bool latency_on_ = false;
+        bool envelope_on_ = false;
+        std::uint64_t push_seq_ = 0; ///< elements ever pushed, numbers envelopes
+        bool trace_on_ = false;
+        QueueCapture *capture_ = nullptr;
+        Hooks hooks_;
+        std::unique_ptr<LockProfile> lock_owner_;
+        std::atomic<LockProfile *> lock_profile_{nullptr};
     };
 
-    template <typename T>
-    void CrossThreadQueue<T>::SetMaxCount(std::size_t ic)
+    template <typename T, typename Hooks, typename Lock>
+    CrossThreadQueue<T, Hooks, Lock>::ProfiledLock::ProfiledLock(CrossThreadQueue &q, QueueOp op)
+        : lck_(q.mutex_, std::defer_lock), op_(static_cast<std::size_t>(op))
+    {
+        auto *profile = q.lock_profile_.load(std::memory_order_acquire);
+        if (profile)
+        {
+            // one countdown per op, so alternating ops are not aliased by the sampling
+            static thread_local std::uint32_t ticks[LockProfile::kOps] = {};
+            auto &tick = ticks[op_];
+            auto every = profile->sample_every.load(std::memory_order_relaxed);
+            if (every && ++tick >= every)
+            {
+                tick = 0;
+                profile_ = profile;
+            }
+        }
+        if (!profile_)
+        {
+            lck_.lock();
+            return;
+        }
+
+        auto begin = QueueClock::NowNs();
+        lck_.lock();
+        acquired_ns_ = QueueClock::NowNs();
+        profile_->wait[op_].Record(acquired_ns_ > begin ? static_cast<std::uint64_t>(acquired_ns_ - begin) : 0);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    CrossThreadQueue<T, Hooks, Lock>::ProfiledLock::~ProfiledLock()
+    {
+        if (profile_)
+            profile_->hold[op_].Record(QueueClock::ElapsedNs(acquired_ns_));
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EnableTracing(bool enable, const std::string &name /* = {} */)
+    {
+        QueueClock::Calibrate();
+        if (!name.empty())
+            TraceRecorder::Instance().NameQueue(this, name);
+        std::unique_lock<Lock> lck(mutex_);
+        trace_on_ = enable;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EnableCapture(QueueCapture *capture)
+    {
+        QueueClock::Calibrate();
+        std::unique_lock<Lock> lck(mutex_);
+        capture_ = capture;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EnableLockProfiling(std::uint32_t sample_every)
+    {
+        QueueClock::Calibrate();
+        std::unique_lock<Lock> lck(mutex_);
+        if (!lock_owner_)
+        {
+            if (sample_every == 0)
+                return;
+            lock_owner_.reset(new LockProfile(sample_every));
+            lock_profile_.store(lock_owner_.get(), std::memory_order_release);
+        }
+        lock_owner_->sample_every.store(sample_every, std::memory_order_relaxed);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::PushBack(const T &t, std::uint32_t producer)
+    {
+        queue_.push_back(t);
+        if (meta_on_)
+        {
+            Envelope env;
+            env.enqueue_ns = QueueClock::NowNs();
+            env.sequence = push_seq_;
+            env.producer = envelope_on_ ? (producer ? producer : CurrentProducerId()) : 0;
+            meta_.push_back(env);
+        }
+        push_seq_++;
+        OnPushed(1);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::PopFront(T *t, Envelope *env)
+    {
+        if (t)
+            *t = queue_.front();
+        queue_.pop_front();
+        if (meta_on_)
+        {
+            if (latency_on_)
+            {
+                auto dt = QueueClock::NowNs() - meta_.front().enqueue_ns;
+                latency_.Record(dt > 0 ? static_cast<std::uint64_t>(dt) : 0);
+            }
+            if (env)
+                *env = envelope_on_ ? meta_.front() : Envelope{};
+            meta_.pop_front();
+        }
+        else if (env)
+        {
+            *env = Envelope{};
+        }
+        OnPopped(1);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::DropFront()
+    {
+        queue_.pop_front();
+        if (meta_on_)
+            meta_.pop_front();
+        OnDropped(1);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EraseAt(std::size_t k)
+    {
+        queue_.erase(queue_.begin() + k);
+        if (meta_on_)
+            meta_.erase(meta_.begin() + k);
+        OnDropped(1);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EnableLatency(bool enable)
+    {
+        QueueClock::Calibrate();
+        std::unique_lock<Lock> lck(mutex_);
+        SetMeta(enable, envelope_on_);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::EnableEnvelope(bool enable)
+    {
+        QueueClock::Calibrate();
+        std::unique_lock<Lock> lck(mutex_);
+        SetMeta(latency_on_, enable);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::SetMeta(bool latency, bool envelope)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        latency_on_ = latency;
+        envelope_on_ = envelope;
+        if (meta_on_ == (latency || envelope))
+            return;
+        meta_on_ = latency || envelope;
+        meta_.clear();
+        if (!meta_on_)
+            return;
+
+        // elements already queued count from now
+        Envelope env;
+        env.enqueue_ns = QueueClock::NowNs();
+        env.sequence = push_seq_ - queue_.size();
+        for (std::size_t i = 0; i < queue_.size(); i++, env.sequence++)
+            meta_.push_back(env);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::SetMaxCount(std::size_t ic)
+    {
+        std::unique_lock<Lock> lck(mutex_);
         max_count_ = ic;
-        while (queue_.size() >= max_count_)
+        counters_.capacity.store(ic, std::memory_order_relaxed);
+        Capture(CaptureOp::SetMaxCount, ic, 0);
+        while (!queue_.empty() && queue_.size() >= max_count_)
         {
-            queue_.pop_front();
+            DropFront();
         }
     }
 
-    template <typename T>
-    size_t CrossThreadQueue<T>::GetMaxCount()
+    template <typename T, typename Hooks, typename Lock>
+    size_t CrossThreadQueue<T, Hooks, Lock>::GetMaxCount()
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        std::unique_lock<Lock> lck(mutex_);
         return max_count_;
     }
 
-    template <typename T>
-    size_t CrossThreadQueue<T>::Size()
+    template <typename T, typename Hooks, typename Lock>
+    size_t CrossThreadQueue<T, Hooks, Lock>::Size()
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        std::unique_lock<Lock> lck(mutex_);
         return queue_.size();
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Full()
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Full()
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        std::unique_lock<Lock> lck(mutex_);
         return queue_.size() == max_count_;
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Empty()
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Empty()
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        std::unique_lock<Lock> lck(mutex_);
         return queue_.empty();
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Try_Push(const T &t)
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Try_Push(const T &t)
+    {
+        return TryPushOne(t, 0);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::TryPushOne(const T &t, std::uint32_t producer)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::Push);
         if (queue_.size() < max_count_)
         {
-            queue_.push_back(t);
+            PushBack(t, producer);
+            Capture(CaptureOp::TryPush, 1, 1);
+            cond_.notify_one();
             return true;
         }
+        Capture(CaptureOp::TryPush, 1, 0);
         return false;
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Try_Push(const std::vector<T> &ts)
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Try_Push(const std::vector<T> &ts)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::PushBatch);
         if (ts.size() + queue_.size() > max_count_)
+        {
+            Capture(CaptureOp::TryPushBatch, ts.size(), 0);
             return false;
+        }
 
         for (auto &t : ts)
-            queue_.push_back(t);
+            PushBack(t);
+        Capture(CaptureOp::TryPushBatch, ts.size(), ts.size());
+        cond_.notify_all();
         return false;
     }
 
-    template <typename T>
-    void CrossThreadQueue<T>::Push(const T &t)
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Push(const T &t)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
-        queue_.push_back(t);
+        PushOne(t, 0);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::PushOne(const T &t, std::uint32_t producer)
+    {
+        ProfiledLock lck(*this, QueueOp::Push);
+        PushBack(t, producer);
+        Capture(CaptureOp::Push, 1, 1);
 
         if (queue_.size() > max_count_)
-            queue_.pop_front();
+        {
+            DropFront();
+        }
+        cond_.notify_one();
     }
 
-    template <typename T>
-    void CrossThreadQueue<T>::Push(const std::vector<T> &ts)
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Push(const std::vector<T> &ts)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::PushBatch);
         for (auto &t : ts)
         {
-            queue_.push_back(t);
+            PushBack(t);
             if (queue_.size() >= max_count_)
             {
-                queue_.pop_front();
+                DropFront();
             }
         }
+        Capture(CaptureOp::PushBatch, ts.size(), ts.size());
+        cond_.notify_all();
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Pop_Must(T *t)
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Pop_Must(T *t)
     {
         using namespace std::chrono_literals;
-        std::unique_lock<std::mutex> lck(mutex_);
+        std::unique_lock<Lock> lck(mutex_);
+        bool waited = queue_.empty();
+        if (waited)
+            OnWaitBegin();
         while (queue_.empty())
         {
             std::this_thread::sleep_for(10ms);
         }
-        *t = queue_.front();
-        queue_.pop_front();
+        if (waited)
+            OnWaitEnd();
+        Capture(CaptureOp::Pop, 1, 1);
+        PopFront(t);
         return true;
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Pop(T *t /* = nullptr */)
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Pop(T *t /* = nullptr */)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::Pop);
+        Capture(CaptureOp::Pop, 1, queue_.empty() ? 0 : 1);
         if (queue_.empty())
             return false;
 
-        if (t)
-            *t = queue_.front();
+        PopFront(t);
+        return true;
+    }
 
-        queue_.pop_front();
+    template <typename T, typename Hooks, typename Lock>
+    auto CrossThreadQueue<T, Hooks, Lock>::Pop(std::size_t num /* = 1 */)
+    {
+        ProfiledLock lck(*this, QueueOp::PopBatch);
+        auto sz = std::min(num, queue_.size());
+        Capture(CaptureOp::PopBatch, num, sz);
+        std::vector<T> ts(sz);
+        for (size_t i = 0; i < sz; i++)
+        {
+            PopFront(&ts[i]);
+        }
+        return ts;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Pop(T *t, Envelope *env)
+    {
+        ProfiledLock lck(*this, QueueOp::Pop);
+        Capture(CaptureOp::Pop, 1, queue_.empty() ? 0 : 1);
+        if (queue_.empty())
+            return false;
+
+        PopFront(t, env);
         return true;
     }
 
-    template <typename T>
-    auto CrossThreadQueue<T>::Pop(std::size_t num /* = 1 */)
+    template <typename T, typename Hooks, typename Lock>
+    std::vector<T> CrossThreadQueue<T, Hooks, Lock>::Pop(std::size_t num, std::vector<Envelope> *envs)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::PopBatch);
         auto sz = std::min(num, queue_.size());
+        Capture(CaptureOp::PopBatch, num, sz);
+        std::vector<T> ts(sz);
+        if (envs)
+            envs->resize(sz);
+        for (size_t i = 0; i < sz; i++)
+        {
+            PopFront(&ts[i], envs ? &(*envs)[i] : nullptr);
+        }
+        return ts;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::WaitLimited(std::unique_lock<Lock> &lck, TokenBucket &bucket, std::size_t num,
+                                          std::chrono::steady_clock::time_point deadline, std::size_t *tokens)
+    {
+        while (true)
+        {
+            if (queue_.empty())
+            {
+                OnWaitBegin();
+                auto status = cond_.wait_until(lck, deadline);
+                OnWaitEnd();
+                if (status == std::cv_status::timeout && queue_.empty())
+                    return false;
+                continue;
+            }
+
+            std::chrono::steady_clock::time_point ready;
+            *tokens = bucket.Take(std::min(num, queue_.size()), std::chrono::steady_clock::now(), &ready);
+            if (*tokens > 0)
+                return true;
+
+            // sleep unlocked so producers and other consumers are not held up
+            OnWaitBegin();
+            lck.unlock();
+            std::this_thread::sleep_until(std::min(ready, deadline));
+            lck.lock();
+            OnWaitEnd();
+            if (ready > deadline)
+                return false;
+        }
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Pop_Limited(TokenBucket &bucket, T *t, std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::min<std::chrono::milliseconds>(timeout, 87600h);
+        std::unique_lock<Lock> lck(mutex_);
+        std::size_t tokens = 0;
+        if (!WaitLimited(lck, bucket, 1, deadline, &tokens))
+        {
+            Capture(CaptureOp::Pop, 1, 0);
+            return false;
+        }
+
+        Capture(CaptureOp::Pop, 1, 1);
+        PopFront(t);
+        return true;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    std::vector<T> CrossThreadQueue<T, Hooks, Lock>::Pop_Limited(TokenBucket &bucket, std::size_t num, std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::min<std::chrono::milliseconds>(timeout, 87600h);
+        std::unique_lock<Lock> lck(mutex_);
+        std::size_t sz = 0;
+        if (num == 0 || !WaitLimited(lck, bucket, num, deadline, &sz))
+        {
+            Capture(CaptureOp::PopBatch, num, 0);
+            return {};
+        }
+        Capture(CaptureOp::PopBatch, num, sz);
+
         std::vector<T> ts(sz);
         for (size_t i = 0; i < sz; i++)
         {
-            ts[i] = queue_.front();
-            queue_.pop_front();
+            PopFront(&ts[i]);
         }
         return ts;
     }
 
-    template <typename T>
-    void CrossThreadQueue<T>::Clear()
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Clear()
     {
-        std::unique_lock<std::mutex> lck(mutex_);
-        queue_.clear();
+        ProfiledLock lck(*this, QueueOp::Clear);
+        auto sz = queue_.size();
+        // one drop per element, as the hooks contract says
+        while (!queue_.empty())
+            DropFront();
+        Capture(CaptureOp::Clear, 0, sz);
     }
 
-    template <typename T>
-    bool CrossThreadQueue<T>::Erase(const T &t)
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Erase(const T &t)
     {
-        std::unique_lock<std::mutex> lck(mutex_);
+        ProfiledLock lck(*this, QueueOp::Erase);
         for (std::size_t k = 0; k < queue_.size(); k++)
         {
             if (t == queue_.at(k))
             {
-                queue_.erase(queue_.begin() + k);
+                EraseAt(k);
+                Capture(CaptureOp::Erase, 1, 1);
                 return true;
             }
         }
+        Capture(CaptureOp::Erase, 1, 0);
         return false;
     }
 
-    template <typename T>
-    void CrossThreadQueue<T>::Sleep(size_t duration)
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::PushToken(ProducerToken &token, std::size_t n, bool drop)
+    {
+        auto &buffer = token.buffer_;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            PushBack(buffer[i], token.producer_);
+            if (drop && queue_.size() > max_count_)
+                DropFront();
+        }
+        Capture(drop ? CaptureOp::PushBatch : CaptureOp::TryPushBatch, buffer.size(), n);
+        buffer.erase(buffer.begin(), buffer.begin() + n);
+        if (n)
+            cond_.notify_all();
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Push(ProducerToken &token, const T &t)
+    {
+        if (token.batch_ == 1)
+            return PushOne(t, token.producer_);
+        token.buffer_.push_back(t);
+        if (token.buffer_.size() >= token.batch_)
+            Flush(token);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Try_Push(ProducerToken &token, const T &t)
+    {
+        if (token.batch_ == 1)
+            return TryPushOne(t, token.producer_);
+        if (token.buffer_.size() >= token.batch_)
+        {
+            ProfiledLock lck(*this, QueueOp::PushBatch);
+            auto room = max_count_ > queue_.size() ? max_count_ - queue_.size() : 0;
+            PushToken(token, std::min(room, token.buffer_.size()), false);
+            if (token.buffer_.size() >= token.batch_)
+                return false;
+        }
+        token.buffer_.push_back(t);
+        return true;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Flush(ProducerToken &token)
+    {
+        if (token.buffer_.empty())
+            return;
+        ProfiledLock lck(*this, QueueOp::PushBatch);
+        PushToken(token, token.buffer_.size(), true);
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    bool CrossThreadQueue<T, Hooks, Lock>::Pop(ConsumerToken &token, T *t)
+    {
+        if (token.batch_ == 1)
+            return Pop(t);
+        auto &cache = token.cache_;
+        if (token.next_ == cache.size())
+        {
+            ProfiledLock lck(*this, QueueOp::PopBatch);
+            auto sz = std::min(token.batch_, queue_.size());
+            Capture(CaptureOp::PopBatch, token.batch_, sz);
+            if (sz == 0)
+                return false;
+            cache.resize(sz);
+            for (std::size_t i = 0; i < sz; i++)
+                PopFront(&cache[i]);
+            token.next_ = 0;
+        }
+        if (t)
+            *t = std::move(cache[token.next_]);
+        if (++token.next_ == cache.size())
+        {
+            cache.clear();
+            token.next_ = 0;
+        }
+        return true;
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Unread(ConsumerToken &token)
+    {
+        auto n = token.Cached();
+        if (n == 0)
+            return;
+        ProfiledLock lck(*this, QueueOp::PushBatch);
+        // a new push of each element, placed back in the order it was taken;
+        // the pops that cached them stand
+        Envelope env;
+        if (meta_on_)
+        {
+            env.enqueue_ns = QueueClock::NowNs();
+            env.producer = envelope_on_ ? CurrentProducerId() : 0;
+        }
+        auto &cache = token.cache_;
+        for (auto i = cache.size(); i-- > token.next_;)
+        {
+            queue_.push_front(std::move(cache[i]));
+            if (meta_on_)
+            {
+                env.sequence = push_seq_ + (i - token.next_);
+                meta_.push_front(env);
+            }
+            OnPushed(1);
+        }
+        push_seq_ += n;
+        Capture(CaptureOp::Unread, n, n);
+        while (queue_.size() > max_count_)
+            DropFront();
+        cache.clear();
+        token.next_ = 0;
+        cond_.notify_all();
+    }
+
+    template <typename T, typename Hooks, typename Lock>
+    void CrossThreadQueue<T, Hooks, Lock>::Sleep(size_t duration)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(duration));
     }
@@ -1,4 +1,5 @@
 #include "cross_thread_queue.hpp"
+#include "queue_registry.hpp"
 #include <string>
 #include <memory>
 #include <random>
@@ -24,6 +25,15 @@ int main()
     Queue que_result;
     std::atomic<bool> running{false};
 
+    auto &registry = Jules::utils::QueueRegistry::Instance();
+    std::vector<Jules::utils::QueueRegistry::Registration> registrations;
+    registrations.emplace_back(registry.Register("vacant", que_vacant));
+    registrations.emplace_back(registry.Register("worker0", que_worker0));
+    registrations.emplace_back(registry.Register("worker10", que_worker10));
+    registrations.emplace_back(registry.Register("worker11", que_worker11));
+    registrations.emplace_back(registry.Register("result", que_result));
+    que_worker0.EnableLatency(true);
+
     std::vector<std::shared_ptr<Dummy>> resource_pool;
     constexpr int resource_num = 200;
     for (int i = 0; i < resource_num; i++)
@@ -87,6 +97,7 @@ int main()
         worker.join();
     }
     printf("[%3lu] [%3lu] [%3lu] [%3lu] [%3lu]\n", que_vacant.Size(), que_worker0.Size(), que_worker10.Size(), que_worker11.Size(), que_result.Size());
+    printf("%s", registry.DumpText().c_str());
     printf("Finished.\n");
 
     return 0;
@@ -0,0 +1,352 @@
+/*
+ * ---------------------------------------
+ * File: fair_queue.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Per-key subqueues served by weighted deficit round robin
+ */
+#ifndef _JULES_FAIR_QUEUE_HPP_
+#define _JULES_FAIR_QUEUE_HPP_
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+
+namespace Jules::utils
+{
+    /// @brief thread safe queue keeping one FIFO per key (producer or tenant)
+    /// @note pop serves keys by deficit round robin, a key with weight w gets
+    ///       w * quantum elements per round while it is backlogged
+    template <typename T, typename Key = std::size_t, typename Hash = std::hash<Key>>
+    class FairQueue
+    {
+    public:
+        explicit FairQueue() = default;
+        FairQueue(const FairQueue &) = delete;
+        FairQueue &operator=(const FairQueue &) = delete;
+        FairQueue(FairQueue &&) = delete;
+        FairQueue &operator=(FairQueue &&) = delete;
+
+        /// @brief set weight of key, kept until changed even while the key is idle
+        /// @param key producer or tenant key
+        /// @param weight share of the key, 0 is treated as 1
+        void SetWeight(const Key &key, std::size_t weight);
+
+        /// @brief set elements served per unit of weight in one round
+        /// @param quantum elements per round, 0 is treated as 1
+        void SetQuantum(std::size_t quantum);
+
+        /// @brief set capacity of queue (all keys)
+        /// @note overflow drops the oldest element of the longest subqueue, which
+        ///       scans the backlogged keys: O(keys) per drop, push and pop
+        ///       stay O(1) otherwise
+        /// @param ic target capacity of queue
+        void SetMaxCount(std::size_t ic);
+
+        /// @brief get capacity of queue
+        /// @return current capacity of queue
+        std::size_t GetMaxCount();
+
+        /// @brief get size of queue (all keys)
+        /// @return current size of queue
+        std::size_t Size();
+
+        /// @brief get size of subqueue
+        /// @param key producer or tenant key
+        /// @return current size of subqueue
+        std::size_t Size(const Key &key);
+
+        /// @brief check if queue is empty
+        /// @return true for empty
+        bool Empty();
+
+        /// @brief key of calling thread, used by keyless Push
+        static Key CurrentProducer();
+
+        /// @brief try to push element into subqueue of key
+        /// @param key producer or tenant key
+        /// @param t element
+        /// @return true for pushed false for full
+        bool Try_Push(const Key &key, const T &t);
+
+        /// @brief push element into subqueue of key
+        /// @param key producer or tenant key
+        /// @param t element
+        void Push(const Key &key, const T &t);
+
+        /// @brief push element into subqueue of calling thread
+        /// @param t element
+        void Push(const T &t);
+
+        /// @brief try to pop element from queue
+        /// @param t pointer to poped element
+        /// @return true for poped false for failed
+        bool Pop(T *t = nullptr);
+
+        /// @brief pop up to num elements in round robin order
+        /// @param num max count of elements
+        /// @return poped elements
+        std::vector<T> Pop(std::size_t num);
+
+        /// @brief clear the queue
+        void Clear();
+
+    private:
+        /// @note a flow stays in flows_ when its key goes idle and is reused on
+        ///       the next push; idle flows with the default weight are swept
+        ///       once enough of them pile up (short-lived producer keys)
+        struct Flow
+        {
+            std::deque<T> items;
+            std::size_t weight = 1;
+            std::size_t deficit = 0;
+            bool active = false;
+        };
+
+        /// @brief idle flows tolerated before the first sweep
+        static constexpr std::size_t kSweepIdle = 64;
+
+        Flow &FlowLocked(const Key &key);
+        void PushLocked(const Key &key, const T &t);
+        void PopLocked(T *t);
+        void DropLocked();
+        void IdleLocked(Flow *flow);
+
+        std::unordered_map<Key, Flow, Hash> flows_;
+        std::deque<Flow *> active_;
+        std::mutex mutex_;
+        std::size_t idle_ = 0;
+        std::size_t sweep_at_ = kSweepIdle;
+        std::size_t size_ = 0;
+        std::size_t quantum_ = 1;
+        std::size_t max_count_ = std::numeric_limits<size_t>::max();
+    };
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::SetWeight(const Key &key, std::size_t weight)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        FlowLocked(key).weight = weight ? weight : 1;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::SetQuantum(std::size_t quantum)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        quantum_ = quantum ? quantum : 1;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::SetMaxCount(std::size_t ic)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        max_count_ = ic;
+        while (size_ > max_count_)
+            DropLocked();
+    }
+
+    template <typename T, typename Key, typename Hash>
+    std::size_t FairQueue<T, Key, Hash>::GetMaxCount()
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return max_count_;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    std::size_t FairQueue<T, Key, Hash>::Size()
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return size_;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    std::size_t FairQueue<T, Key, Hash>::Size(const Key &key)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        auto it = flows_.find(key);
+        return it == flows_.end() ? 0 : it->second.items.size();
+    }
+
+    template <typename T, typename Key, typename Hash>
+    bool FairQueue<T, Key, Hash>::Empty()
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return size_ == 0;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    Key FairQueue<T, Key, Hash>::CurrentProducer()
+    {
+        return static_cast<Key>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    }
+
+    template <typename T, typename Key, typename Hash>
+    typename FairQueue<T, Key, Hash>::Flow &FairQueue<T, Key, Hash>::FlowLocked(const Key &key)
+    {
+        auto it = flows_.find(key);
+        if (it == flows_.end())
+        {
+            it = flows_.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).first;
+            idle_++;
+        }
+        return it->second;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::PushLocked(const Key &key, const T &t)
+    {
+        auto &flow = FlowLocked(key);
+        flow.items.push_back(t);
+        size_++;
+        if (!flow.active)
+        {
+            flow.active = true;
+            flow.deficit = 0;
+            idle_--;
+            active_.push_back(&flow);
+        }
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::IdleLocked(Flow *flow)
+    {
+        flow->active = false;
+        flow->deficit = 0;
+        if (++idle_ < sweep_at_)
+            return;
+
+        // amortized: the next sweep waits for as many new idle flows as
+        // there are flows left, so each idle transition pays O(1)
+        for (auto it = flows_.begin(); it != flows_.end();)
+        {
+            if (!it->second.active && it->second.weight == 1)
+            {
+                it = flows_.erase(it);
+                idle_--;
+            }
+            else
+                ++it;
+        }
+        sweep_at_ = idle_ + (flows_.size() > kSweepIdle ? flows_.size() : kSweepIdle);
+    }
+
+    template <typename T, typename Key, typename Hash>
+    bool FairQueue<T, Key, Hash>::Try_Push(const Key &key, const T &t)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (size_ >= max_count_)
+            return false;
+        PushLocked(key, t);
+        return true;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::Push(const Key &key, const T &t)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        PushLocked(key, t);
+        if (size_ > max_count_)
+            DropLocked();
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::Push(const T &t)
+    {
+        Push(CurrentProducer(), t);
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::PopLocked(T *t)
+    {
+        auto *flow = active_.front();
+        if (flow->deficit == 0)
+            flow->deficit = flow->weight * quantum_;
+
+        if (t)
+            *t = flow->items.front();
+        flow->items.pop_front();
+        flow->deficit--;
+        size_--;
+
+        if (flow->items.empty())
+        {
+            active_.pop_front();
+            IdleLocked(flow);
+        }
+        else if (flow->deficit == 0)
+        {
+            active_.pop_front();
+            active_.push_back(flow);
+        }
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::DropLocked()
+    {
+        auto longest = active_.end();
+        for (auto it = active_.begin(); it != active_.end(); ++it)
+        {
+            if (longest == active_.end() || (*it)->items.size() > (*longest)->items.size())
+                longest = it;
+        }
+        if (longest == active_.end())
+            return;
+
+        auto *flow = *longest;
+        flow->items.pop_front();
+        size_--;
+        if (flow->items.empty())
+        {
+            active_.erase(longest);
+            IdleLocked(flow);
+        }
+    }
+
+    template <typename T, typename Key, typename Hash>
+    bool FairQueue<T, Key, Hash>::Pop(T *t /* = nullptr */)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (active_.empty())
+            return false;
+
+        PopLocked(t);
+        return true;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    std::vector<T> FairQueue<T, Key, Hash>::Pop(std::size_t num)
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        auto sz = std::min(num, size_);
+        std::vector<T> ts(sz);
+        for (std::size_t i = 0; i < sz; i++)
+            PopLocked(&ts[i]);
+        return ts;
+    }
+
+    template <typename T, typename Key, typename Hash>
+    void FairQueue<T, Key, Hash>::Clear()
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        for (auto *flow : active_)
+            flow->items.clear();
+        auto idle = std::move(active_);
+        active_.clear();
+        size_ = 0;
+        for (auto *flow : idle)
+            IdleLocked(flow);
+    }
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,284 @@
+/*
+ * ---------------------------------------
+ * File: flight_recorder.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Always-on ring of recent queue events for post-mortem diagnostics
+ * - Linux/POSIX only (signal safe dump uses open/write)
+ */
+#ifndef _JULES_FLIGHT_RECORDER_HPP_
+#define _JULES_FLIGHT_RECORDER_HPP_
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "queue_trace.hpp"
+
+#ifndef JULES_CTQ_FLIGHT_THREADS
+#define JULES_CTQ_FLIGHT_THREADS 64
+#endif
+#ifndef JULES_CTQ_FLIGHT_EVENTS
+#define JULES_CTQ_FLIGHT_EVENTS 1024
+#endif
+
+namespace Jules::utils
+{
+    /// @brief fixed-size per-thread rings keeping the last events of each thread
+    /// @note all memory is allocated once; recording is a few plain stores and
+    ///       dumping only uses async-signal-safe calls, so it works from a
+    ///       crash handler. A thread gives its ring back when it exits; the
+    ///       events stay dumpable until a new thread takes the ring over,
+    ///       the one idle longest first. While more than kThreads threads
+    ///       record at once, the extra ones are not recorded.
+    class FlightRecorder
+    {
+    public:
+        static constexpr std::size_t kThreads = JULES_CTQ_FLIGHT_THREADS;
+        static constexpr std::size_t kEvents = JULES_CTQ_FLIGHT_EVENTS;
+
+        static FlightRecorder &Instance()
+        {
+            static FlightRecorder recorder;
+            return recorder;
+        }
+
+        /// @brief record one event of the calling thread
+        void Record(TraceOp op, const void *queue, std::size_t size)
+        {
+            static thread_local Slot slot;
+            if (!slot.ring)
+                slot.ring = Claim();
+            auto *ring = slot.ring;
+            if (!ring)
+                return;
+            auto w = ring->written.load(std::memory_order_relaxed);
+            ring->events[w % kEvents] = TraceEvent{QueueClock::NowNs(), queue, static_cast<std::uint32_t>(size), op};
+            ring->written.store(w + 1, std::memory_order_release);
+        }
+
+        /// @brief write recent events as text lines, async-signal-safe
+        /// @param fd open file descriptor
+        void DumpToFd(int fd)
+        {
+            char line[160];
+            auto used = used_.load(std::memory_order_acquire);
+            if (used > kThreads)
+                used = kThreads;
+            WriteAll(fd, "# ts_ns tid queue op size\n", 26);
+            for (std::size_t r = 0; r < used; r++)
+            {
+                auto &ring = rings_[r];
+                auto written = ring.written.load(std::memory_order_acquire);
+                auto begin = written > kEvents ? written - kEvents : 0;
+                for (auto i = begin; i < written; i++)
+                {
+                    auto &e = ring.events[i % kEvents];
+                    char *p = line;
+                    p = AppendUnsigned(p, static_cast<std::uint64_t>(e.ts_ns), 10);
+                    *p++ = ' ';
+                    p = AppendUnsigned(p, ring.tid, 10);
+                    *p++ = ' ';
+                    *p++ = '0';
+                    *p++ = 'x';
+                    p = AppendUnsigned(p, reinterpret_cast<std::uintptr_t>(e.queue), 16);
+                    *p++ = ' ';
+                    auto *name = TraceRecorder::OpName(e.op);
+                    auto len = strlen(name);
+                    memcpy(p, name, len);
+                    p += len;
+                    *p++ = ' ';
+                    p = AppendUnsigned(p, e.size, 10);
+                    *p++ = '\n';
+                    WriteAll(fd, line, static_cast<std::size_t>(p - line));
+                }
+            }
+        }
+
+        /// @brief write recent events to a local file, async-signal-safe
+        /// @param path file path, replaced
+        /// @return true for written
+        bool DumpToFile(const char *path)
+        {
+            int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+                return false;
+            DumpToFd(fd);
+            return close(fd) == 0;
+        }
+
+        /// @brief dump to path when signo is delivered
+        /// @note fatal signals (SIGSEGV, SIGABRT, ...) are re-raised with the
+        ///       default action after the dump; others (SIGUSR1) just dump
+        /// @param path file path, copied
+        /// @param signo signal number
+        /// @return true for installed
+        bool InstallSignalDump(const char *path, int signo)
+        {
+            if (strlen(path) >= sizeof(dump_path_))
+                return false;
+            strcpy(dump_path_, path);
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = &FlightRecorder::OnSignal;
+            sigemptyset(&sa.sa_mask);
+            sa.sa_flags = SA_RESTART;
+            return sigaction(signo, &sa, nullptr) == 0;
+        }
+
+    private:
+        struct Ring
+        {
+            TraceEvent events[kEvents];
+            std::atomic<std::uint64_t> written{0};
+            std::uint32_t tid = 0;
+            std::atomic<bool> owned{true}; ///< a live thread records into it, or not handed out yet
+            std::atomic<std::int64_t> released_ns{0}; ///< when the owner gave it back
+        };
+
+        /// @brief ring of the calling thread, given back when the thread exits
+        struct Slot
+        {
+            Ring *ring = nullptr;
+            ~Slot()
+            {
+                if (ring)
+                    Instance().Release(ring);
+            }
+        };
+
+        FlightRecorder() : rings_(new Ring[kThreads]) { QueueClock::Calibrate(); }
+
+        /// @return a never used ring, else the released one idle longest, else null
+        Ring *Claim()
+        {
+            if (used_.load(std::memory_order_relaxed) < kThreads)
+            {
+                auto idx = used_.fetch_add(1, std::memory_order_acq_rel);
+                if (idx < kThreads)
+                {
+                    Own(rings_[idx], idx);
+                    return &rings_[idx];
+                }
+                used_.store(kThreads, std::memory_order_relaxed);
+            }
+            // rings start owned, so the scan only ever sees released ones
+            while (released_.load(std::memory_order_acquire) > 0)
+            {
+                Ring *oldest = nullptr;
+                std::size_t oldest_idx = 0;
+                auto used = used_.load(std::memory_order_acquire);
+                if (used > kThreads)
+                    used = kThreads;
+                for (std::size_t r = 0; r < used; r++)
+                {
+                    auto &ring = rings_[r];
+                    if (ring.owned.load(std::memory_order_relaxed))
+                        continue;
+                    if (!oldest || ring.released_ns.load(std::memory_order_relaxed) <
+                                       oldest->released_ns.load(std::memory_order_relaxed))
+                    {
+                        oldest = &ring;
+                        oldest_idx = r;
+                    }
+                }
+                bool expected = false;
+                if (oldest && oldest->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    released_.fetch_sub(1, std::memory_order_relaxed);
+                    Own(*oldest, oldest_idx);
+                    return oldest;
+                }
+            }
+            return nullptr;
+        }
+
+        void Release(Ring *ring)
+        {
+            ring->released_ns.store(QueueClock::NowNs(), std::memory_order_relaxed);
+            ring->owned.store(false, std::memory_order_release);
+            released_.fetch_add(1, std::memory_order_release);
+        }
+
+        /// @brief start a claimed ring over for the calling thread
+        void Own(Ring &ring, std::size_t idx)
+        {
+            ring.written.store(0, std::memory_order_release);
+#ifdef __linux__
+            (void)idx;
+            ring.tid = static_cast<std::uint32_t>(syscall(SYS_gettid));
+#else
+            ring.tid = static_cast<std::uint32_t>(idx + 1);
+#endif
+        }
+
+        static void OnSignal(int signo)
+        {
+            auto saved = errno;
+            auto &self = Instance();
+            self.DumpToFile(self.dump_path_);
+            if (signo != SIGUSR1 && signo != SIGUSR2)
+            {
+                signal(signo, SIG_DFL);
+                raise(signo);
+            }
+            errno = saved;
+        }
+
+        static char *AppendUnsigned(char *p, std::uint64_t v, unsigned base)
+        {
+            char tmp[24];
+            int n = 0;
+            do
+            {
+                tmp[n++] = "0123456789abcdef"[v % base];
+                v /= base;
+            } while (v);
+            while (n)
+                *p++ = tmp[--n];
+            return p;
+        }
+
+        static void WriteAll(int fd, const char *data, std::size_t len)
+        {
+            while (len > 0)
+            {
+                auto n = write(fd, data, len);
+                if (n <= 0)
+                {
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    return;
+                }
+                data += n;
+                len -= static_cast<std::size_t>(n);
+            }
+        }
+
+        Ring *rings_; ///< never freed, may be read by a crash handler at exit
+        std::atomic<std::size_t> used_{0};     ///< rings ever handed out, up to kThreads
+        std::atomic<std::size_t> released_{0}; ///< rings given back by exited threads
+        char dump_path_[256] = {};
+    };
+
+    /// @brief hooks policy feeding FlightRecorder, e.g. CrossThreadQueue<T, FlightRecorderHooks>
+    struct FlightRecorderHooks
+    {
+        FlightRecorderHooks() { FlightRecorder::Instance(); } // calibrates the clock, not under the queue lock later
+
+        void OnPush(const void *queue, std::size_t size) { FlightRecorder::Instance().Record(TraceOp::Push, queue, size); }
+        void OnPop(const void *queue, std::size_t size) { FlightRecorder::Instance().Record(TraceOp::Pop, queue, size); }
+        void OnDrop(const void *queue, std::size_t size) { FlightRecorder::Instance().Record(TraceOp::Drop, queue, size); }
+        void OnWaitBegin(const void *queue) { FlightRecorder::Instance().Record(TraceOp::WaitBegin, queue, 0); }
+        void OnWaitEnd(const void *queue) { FlightRecorder::Instance().Record(TraceOp::WaitEnd, queue, 0); }
+    };
+
+} // ! namespace Jules::utils
+
+#endif
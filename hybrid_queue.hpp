@@ -0,0 +1,577 @@
+/*
+ * ---------------------------------------
+ * File: hybrid_queue.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - CrossThreadQueue API with lock-free Push/Pop on a ring and an
+ *   exclusive slow path for Erase, Clear and SetMaxCount
+ */
+#ifndef _JULES_HYBRID_QUEUE_HPP_
+#define _JULES_HYBRID_QUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "queue_stats.hpp"
+#include "quiescing_gate.hpp"
+#include "token_bucket.hpp"
+
+namespace Jules::utils
+{
+    /// @tparam T element type, default constructible and assignable
+    /// @note Push and Pop run on a bounded MPMC ring (per-cell sequence
+    ///       numbers, one CAS per element) without taking a lock. Erase,
+    ///       Clear, SetMaxCount and ring growth quiesce the ring: they raise
+    ///       a flag, wait until no fast path operation is in flight and then
+    ///       work on it alone; fast operations arriving meanwhile block on
+    ///       the slow path mutex until it is done.
+    ///       The ring starts at ring_capacity cells and doubles on demand up
+    ///       to the max count, so an unbounded queue stays unbounded.
+    ///       Differences from CrossThreadQueue: capacity is checked against
+    ///       an approximate size, so concurrent pushers may overshoot it by
+    ///       one element each; Push(ts) and Pop(num) are not atomic as a
+    ///       batch (Try_Push(ts) still is all-or-nothing); there is no
+    ///       latency, envelope, lock profiling, tracing or capture support.
+    template <typename T>
+    class HybridQueue
+    {
+    public:
+        /// @param ring_capacity initial ring cells, rounded up to a power of two
+        explicit HybridQueue(std::size_t ring_capacity = 1024)
+        {
+            Reset(RoundUp(ring_capacity));
+        }
+        HybridQueue(const HybridQueue &) = delete;
+        HybridQueue &operator=(const HybridQueue &) = delete;
+        HybridQueue(HybridQueue &&) = delete;
+        HybridQueue &operator=(HybridQueue &&) = delete;
+
+        /// @brief set capacity of queue, slow path; like CrossThreadQueue it
+        ///        drops the oldest elements until fewer than ic are left
+        /// @param ic target capacity of queue
+        void SetMaxCount(std::size_t ic);
+
+        /// @brief get capacity of queue
+        /// @return current capacity of queue
+        std::size_t GetMaxCount() { return max_count_.load(std::memory_order_relaxed); }
+
+        /// @brief get size of queue
+        /// @return current size of queue, approximate while operations are in flight
+        std::size_t Size()
+        {
+            auto d = deq_.pos.load(std::memory_order_acquire);
+            auto e = enq_.pos.load(std::memory_order_acquire);
+            return e > d ? e - d : 0;
+        }
+
+        /// @brief check if queue is full
+        /// @return true for full
+        bool Full() { return Size() >= GetMaxCount(); }
+
+        /// @brief check if queue is empty
+        /// @return true for empty
+        bool Empty() { return Size() == 0; }
+
+        /// @brief try to push element into queue
+        /// @param t element
+        /// @return true for pushed false for full
+        bool Try_Push(const T &t);
+
+        /// @brief try to push all elements into queue, none if they do not fit
+        /// @param ts vector of elements
+        /// @return true for pushed false for full
+        bool Try_Push(const std::vector<T> &ts);
+
+        /// @brief push element into queue, dropping the oldest when full
+        /// @param t element
+        void Push(const T &t);
+
+        /// @brief push elements into queue one by one
+        /// @param ts vector of elements
+        void Push(const std::vector<T> &ts);
+
+        /// @brief try to pop element from queue
+        /// @param t pointer to poped element
+        /// @return true for poped false for empty
+        bool Pop(T *t = nullptr);
+
+        /// @brief pop up to num elements
+        /// @param num max count of elements
+        /// @return poped elements
+        std::vector<T> Pop(std::size_t num);
+
+        /// @warning polls every 10 ms, better not use!
+        [[deprecated("Potential risk of deadlock, better not use!")]] bool Pop_Must(T *t);
+
+        /// @brief pop element paced by token bucket
+        /// @note a consumer that loses the element to another one after
+        ///       taking a token forfeits that token
+        /// @param bucket token bucket, may be shared by several consumers
+        /// @param t pointer to poped element
+        /// @param timeout max time to wait
+        /// @return true for poped false for timeout
+        bool Pop_Limited(TokenBucket &bucket, T *t, std::chrono::milliseconds timeout);
+
+        /// @brief pop up to num elements paced by token bucket
+        /// @param bucket token bucket, may be shared by several consumers
+        /// @param num max count of elements
+        /// @param timeout max time to wait
+        /// @return poped elements, empty for timeout
+        std::vector<T> Pop_Limited(TokenBucket &bucket, std::size_t num, std::chrono::milliseconds timeout);
+
+        /// @brief clear the queue, slow path
+        void Clear();
+
+        /// @brief erase first element equal to t, slow path
+        /// @param t element value to erase
+        /// @return true for erased false for not found
+        bool Erase(const T &t);
+
+        /// @brief Sleep auxiliary function(thread independent)
+        /// @param duration time duration in millisecond
+        static void Sleep(size_t duration)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+        }
+
+        /// @brief element counters, readable without locking the queue
+        const QueueCounters &Counters() const { return counters_; }
+
+        /// @brief always empty, kept so the queue can be registered like CrossThreadQueue
+        const LatencyHistogram &Latency() const { return latency_; }
+
+        /// @brief always null, the fast path has no lock to profile
+        const LockProfile *LockStats() const { return nullptr; }
+
+        /// @brief current ring cells
+        std::size_t RingCapacity() { return cap_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> seq{0};
+            T value{};
+        };
+
+        /// @brief padded to a cache line so enq_ and deq_ never share one;
+        ///        padding rather than alignas keeps the queue heap allocatable in C++14
+        struct Position
+        {
+            std::atomic<std::size_t> pos{0};
+            char pad[64 - sizeof(std::atomic<std::size_t>)];
+        };
+
+        static std::size_t RoundUp(std::size_t n)
+        {
+            std::size_t cap = 2;
+            while (cap < n)
+                cap <<= 1;
+            return cap;
+        }
+
+        /// @brief install an empty ring, caller is alone
+        void Reset(std::size_t cap)
+        {
+            cells_.reset(new Cell[cap]);
+            for (std::size_t i = 0; i < cap; i++)
+                cells_[i].seq.store(i, std::memory_order_relaxed);
+            mask_ = cap - 1;
+            cap_.store(cap, std::memory_order_relaxed);
+            enq_.pos.store(0, std::memory_order_relaxed);
+            deq_.pos.store(0, std::memory_order_relaxed);
+        }
+
+        bool Enqueue(const T &t);
+        bool Dequeue(T *t);
+        bool EnqueueAll(const std::vector<T> &ts);
+        void DropOne();
+        /// @brief drop the n oldest elements, caller is alone
+        void DropOldest(std::size_t n);
+        void Grow(std::size_t at_least);
+        void NotifyWaiters();
+        bool WaitNonEmpty(std::chrono::steady_clock::time_point deadline);
+
+        Position enq_;
+        Position deq_;
+        std::unique_ptr<Cell[]> cells_;
+        std::size_t mask_ = 0;
+        std::atomic<std::size_t> cap_{0};
+        std::atomic<std::size_t> max_count_{std::numeric_limits<std::size_t>::max()};
+
+        QuiescingGate gate_; ///< Push/Pop pass it, slow path operations close it
+
+        std::atomic<std::uint32_t> waiters_{0}; ///< threads blocked in Pop_Limited
+        std::mutex wait_mutex_;
+        std::condition_variable wait_cond_;
+
+        QueueCounters counters_{true}; ///< sharded, updated outside any lock
+        LatencyHistogram latency_;
+    };
+
+    template <typename T>
+    bool HybridQueue<T>::Enqueue(const T &t)
+    {
+        auto pos = enq_.pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto &cell = cells_[pos & mask_];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (dif == 0)
+            {
+                if (enq_.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = t;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    counters_.pushed.Add(1);
+                    return true;
+                }
+            }
+            else if (dif < 0)
+                return false; // full
+            else
+                pos = enq_.pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Dequeue(T *t)
+    {
+        auto pos = deq_.pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto &cell = cells_[pos & mask_];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (dif == 0)
+            {
+                if (deq_.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    if (t)
+                        *t = std::move(cell.value);
+                    cell.value = T();
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0)
+                return false; // empty, or the next element is not published yet
+            else
+                pos = deq_.pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::EnqueueAll(const std::vector<T> &ts)
+    {
+        // claim ts.size() positions at once; their previous occupants are
+        // already claimed by consumers, wait for each to be released
+        auto n = ts.size();
+        auto pos = enq_.pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            // d > pos means pos is stale, the CAS fails and reloads it
+            auto d = deq_.pos.load(std::memory_order_acquire);
+            if (d <= pos && pos + n - d > mask_ + 1)
+                return false;
+            if (enq_.pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                break;
+        }
+
+        for (std::size_t i = 0; i < n; i++)
+        {
+            auto &cell = cells_[(pos + i) & mask_];
+            while (cell.seq.load(std::memory_order_acquire) != pos + i)
+                std::this_thread::yield();
+            cell.value = ts[i];
+            cell.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        counters_.pushed.Add(n);
+        return true;
+    }
+
+    template <typename T>
+    void HybridQueue<T>::DropOne()
+    {
+        if (Dequeue(nullptr))
+            counters_.dropped.Add(1);
+    }
+
+    template <typename T>
+    void HybridQueue<T>::DropOldest(std::size_t n)
+    {
+        auto d = deq_.pos.load(std::memory_order_relaxed);
+        for (auto p = d; p < d + n; p++)
+        {
+            auto &cell = cells_[p & mask_];
+            cell.value = T();
+            cell.seq.store(p + mask_ + 1, std::memory_order_relaxed);
+        }
+        deq_.pos.store(d + n, std::memory_order_relaxed);
+        counters_.dropped.Add(n);
+    }
+
+    template <typename T>
+    void HybridQueue<T>::Grow(std::size_t at_least)
+    {
+        gate_.Exclusive([&]
+                  {
+            auto cap = mask_ + 1;
+            if (cap >= at_least)
+                return; // grown by another thread meanwhile
+            std::unique_ptr<Cell[]> old(cells_.release());
+            auto d = deq_.pos.load(std::memory_order_relaxed);
+            auto e = enq_.pos.load(std::memory_order_relaxed);
+            Reset(RoundUp(at_least));
+            std::size_t n = 0;
+            for (auto p = d; p < e; p++, n++)
+            {
+                cells_[n].value = std::move(old[p & (cap - 1)].value);
+                cells_[n].seq.store(n + 1, std::memory_order_relaxed);
+            }
+            enq_.pos.store(n, std::memory_order_relaxed); });
+    }
+
+    template <typename T>
+    void HybridQueue<T>::NotifyWaiters()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0)
+            return;
+        std::unique_lock<std::mutex> lck(wait_mutex_);
+        wait_cond_.notify_all();
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::WaitNonEmpty(std::chrono::steady_clock::time_point deadline)
+    {
+        if (Size() > 0)
+            return true;
+        std::unique_lock<std::mutex> lck(wait_mutex_);
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = true;
+        while (Size() == 0)
+        {
+            if (wait_cond_.wait_until(lck, deadline) == std::cv_status::timeout && Size() == 0)
+            {
+                ready = false;
+                break;
+            }
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return ready;
+    }
+
+    template <typename T>
+    void HybridQueue<T>::SetMaxCount(std::size_t ic)
+    {
+        gate_.Exclusive([&]
+                  {
+            max_count_.store(ic, std::memory_order_relaxed);
+            counters_.capacity.store(ic, std::memory_order_relaxed);
+            auto size = Size();
+            if (size >= ic)
+                DropOldest(ic ? size - ic + 1 : size); });
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Try_Push(const T &t)
+    {
+        for (;;)
+        {
+            {
+                QuiescingGate::Scope fp(gate_);
+                auto max = max_count_.load(std::memory_order_relaxed);
+                if (Size() >= max)
+                    return false;
+                if (Enqueue(t))
+                    break;
+                if (mask_ + 1 >= max)
+                    return false;
+            }
+            Grow(RingCapacity() * 2);
+        }
+        NotifyWaiters();
+        return true;
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Try_Push(const std::vector<T> &ts)
+    {
+        if (ts.empty())
+            return true;
+        for (;;)
+        {
+            {
+                QuiescingGate::Scope fp(gate_);
+                auto max = max_count_.load(std::memory_order_relaxed);
+                if (ts.size() > max || Size() > max - ts.size())
+                    return false;
+                if (EnqueueAll(ts))
+                    break;
+                if (mask_ + 1 >= max)
+                    return false;
+            }
+            Grow(std::max(RingCapacity() * 2, Size() + ts.size()));
+        }
+        NotifyWaiters();
+        return true;
+    }
+
+    template <typename T>
+    void HybridQueue<T>::Push(const T &t)
+    {
+        for (;;)
+        {
+            {
+                QuiescingGate::Scope fp(gate_);
+                auto max = max_count_.load(std::memory_order_relaxed);
+                if (Size() >= max)
+                    DropOne();
+                if (Enqueue(t))
+                {
+                    if (max == 0)
+                        DropOne(); // pushed and dropped, as CrossThreadQueue does
+                    break;
+                }
+                if (mask_ + 1 >= max)
+                {
+                    DropOne();
+                    continue;
+                }
+            }
+            Grow(RingCapacity() * 2);
+        }
+        NotifyWaiters();
+    }
+
+    template <typename T>
+    void HybridQueue<T>::Push(const std::vector<T> &ts)
+    {
+        for (auto &t : ts)
+            Push(t);
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Pop(T *t /* = nullptr */)
+    {
+        QuiescingGate::Scope fp(gate_);
+        if (!Dequeue(t))
+            return false;
+        counters_.popped.Add(1);
+        return true;
+    }
+
+    template <typename T>
+    std::vector<T> HybridQueue<T>::Pop(std::size_t num)
+    {
+        std::vector<T> ts;
+        QuiescingGate::Scope fp(gate_);
+        ts.reserve(std::min(num, Size()));
+        T t;
+        while (ts.size() < num && Dequeue(&t))
+            ts.push_back(std::move(t));
+        counters_.popped.Add(ts.size());
+        return ts;
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Pop_Must(T *t)
+    {
+        while (!Pop(t))
+            Sleep(10);
+        return true;
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Pop_Limited(TokenBucket &bucket, T *t, std::chrono::milliseconds timeout)
+    {
+        using namespace std::chrono_literals;
+        auto deadline = std::chrono::steady_clock::now() + std::min<std::chrono::milliseconds>(timeout, 87600h);
+        for (;;)
+        {
+            if (!WaitNonEmpty(deadline))
+                return false;
+            std::chrono::steady_clock::time_point ready;
+            if (bucket.Take(1, std::chrono::steady_clock::now(), &ready) > 0)
+            {
+                if (Pop(t))
+                    return true;
+                continue;
+            }
+            std::this_thread::sleep_until(std::min(ready, deadline));
+            if (ready > deadline)
+                return false;
+        }
+    }
+
+    template <typename T>
+    std::vector<T> HybridQueue<T>::Pop_Limited(TokenBucket &bucket, std::size_t num, std::chrono::milliseconds timeout)
+    {
+        using namespace std::chrono_literals;
+        auto deadline = std::chrono::steady_clock::now() + std::min<std::chrono::milliseconds>(timeout, 87600h);
+        while (num > 0)
+        {
+            if (!WaitNonEmpty(deadline))
+                break;
+            std::chrono::steady_clock::time_point ready;
+            auto tokens = bucket.Take(std::min(num, std::max<std::size_t>(Size(), 1)), std::chrono::steady_clock::now(), &ready);
+            if (tokens > 0)
+            {
+                auto ts = Pop(tokens);
+                if (!ts.empty())
+                    return ts;
+                continue;
+            }
+            std::this_thread::sleep_until(std::min(ready, deadline));
+            if (ready > deadline)
+                break;
+        }
+        return {};
+    }
+
+    template <typename T>
+    void HybridQueue<T>::Clear()
+    {
+        gate_.Exclusive([&]
+                  { DropOldest(Size()); });
+    }
+
+    template <typename T>
+    bool HybridQueue<T>::Erase(const T &t)
+    {
+        bool found = false;
+        gate_.Exclusive([&]
+                  {
+            auto d = deq_.pos.load(std::memory_order_relaxed);
+            auto e = enq_.pos.load(std::memory_order_relaxed);
+            auto p = d;
+            while (p < e && !(t == cells_[p & mask_].value))
+                p++;
+            if (p == e)
+                return;
+            // close the gap, the last cell becomes free for position e - 1
+            for (; p + 1 < e; p++)
+                cells_[p & mask_].value = std::move(cells_[(p + 1) & mask_].value);
+            cells_[(e - 1) & mask_].value = T();
+            cells_[(e - 1) & mask_].seq.store(e - 1, std::memory_order_relaxed);
+            enq_.pos.store(e - 1, std::memory_order_relaxed);
+            counters_.dropped.Add(1);
+            found = true; });
+        return found;
+    }
+
+} // ! namespace Jules::utils
+
+#endif
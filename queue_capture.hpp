@@ -0,0 +1,218 @@
+/*
+ * ---------------------------------------
+ * File: queue_capture.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Per-thread capture of queue calls to a compact binary file, for replay
+ */
+#ifndef _JULES_QUEUE_CAPTURE_HPP_
+#define _JULES_QUEUE_CAPTURE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queue_clock.hpp"
+
+namespace Jules::utils
+{
+    /// @brief queue calls kept by a capture
+    enum class CaptureOp : std::uint8_t
+    {
+        Push,         ///< Push(t)
+        PushBatch,    ///< Push(ts)
+        TryPush,      ///< Try_Push(t)
+        TryPushBatch, ///< Try_Push(ts)
+        Pop,          ///< Pop(t), Pop_Limited(t)
+        PopBatch,     ///< Pop(num), Pop_Limited(num)
+        Erase,
+        Clear,
+        SetMaxCount, ///< requested holds the capacity, clamped
+        Unread,      ///< Unread(token): cached elements put back at the front
+        Count
+    };
+
+    inline const char *CaptureOpName(CaptureOp op)
+    {
+        static const char *names[] = {"push", "push_batch", "try_push", "try_push_batch", "pop", "pop_batch",
+                                      "erase", "clear", "set_max_count", "unread"};
+        return op < CaptureOp::Count ? names[static_cast<std::size_t>(op)] : "unknown";
+    }
+
+    /// @brief one call, 16 bytes
+    struct CaptureRecord
+    {
+        std::uint64_t ts_ns;  ///< since the capture was created
+        std::uint32_t op_req; ///< op in the top 8 bits, requested elements below
+        std::uint32_t done;   ///< elements actually moved
+
+        static constexpr std::uint32_t kMaxRequested = (1u << 24) - 1;
+
+        CaptureOp Op() const { return static_cast<CaptureOp>(op_req >> 24); }
+        std::uint32_t Requested() const { return op_req & kMaxRequested; }
+    };
+    static_assert(sizeof(CaptureRecord) == 16, "capture file layout");
+
+    /// @brief calls of one thread, in order
+    struct CaptureThread
+    {
+        std::uint32_t thread = 0; ///< index in capture order, from 0
+        std::vector<CaptureRecord> records;
+    };
+
+    /// @brief records every call made on the queues it is attached to
+    /// @note attach with CrossThreadQueue::EnableCapture. Each thread appends
+    ///       to its own buffer, found through a one-entry thread local cache,
+    ///       so recording takes no shared lock after a thread's first call;
+    ///       buffers grow by doubling, reserve with per_thread to avoid that.
+    ///       Save or Threads only after the recorded threads have stopped.
+    ///
+    ///       File: "CTQCAP1\0", u32 thread count, u32 reserved, then per
+    ///       thread u32 index, u32 reserved, u64 record count and the records.
+    ///       Little endian, as written by the host.
+    class QueueCapture
+    {
+    public:
+        /// @param per_thread records reserved for each thread
+        explicit QueueCapture(std::size_t per_thread = 1 << 16)
+            : id_(NextId()), per_thread_(per_thread), start_ns_(QueueClock::NowNs())
+        {
+        }
+        QueueCapture(const QueueCapture &) = delete;
+        QueueCapture &operator=(const QueueCapture &) = delete;
+
+        /// @brief append a call of the calling thread
+        void Record(CaptureOp op, std::size_t requested, std::size_t done)
+        {
+            CaptureRecord r;
+            r.ts_ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, QueueClock::NowNs() - start_ns_));
+            r.op_req = (static_cast<std::uint32_t>(op) << 24) |
+                       static_cast<std::uint32_t>(std::min<std::size_t>(requested, CaptureRecord::kMaxRequested));
+            r.done = static_cast<std::uint32_t>(std::min<std::size_t>(done, UINT32_MAX));
+            Local()->records.push_back(r);
+        }
+
+        /// @brief recorded threads, in order of their first call
+        const std::vector<std::unique_ptr<CaptureThread>> &Threads() const { return threads_; }
+
+        /// @brief write the capture to a local file
+        /// @param path file path, replaced
+        /// @return true for written
+        bool Save(const std::string &path)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            std::unique_ptr<FILE, int (*)(FILE *)> f(fopen(path.c_str(), "wb"), &fclose);
+            if (!f)
+                return false;
+            std::uint32_t head[2] = {static_cast<std::uint32_t>(threads_.size()), 0};
+            bool ok = fwrite(Magic(), 1, 8, f.get()) == 8 && fwrite(head, sizeof(head), 1, f.get()) == 1;
+            for (auto &t : threads_)
+            {
+                std::uint32_t id[2] = {t->thread, 0};
+                std::uint64_t count = t->records.size();
+                ok = ok && fwrite(id, sizeof(id), 1, f.get()) == 1 && fwrite(&count, sizeof(count), 1, f.get()) == 1;
+                ok = ok && (count == 0 || fwrite(t->records.data(), sizeof(CaptureRecord), count, f.get()) == count);
+            }
+            return ok && fflush(f.get()) == 0;
+        }
+
+        /// @brief read a capture file
+        /// @param path file path
+        /// @param out receives one entry per recorded thread
+        /// @return true for read, false for missing or malformed file
+        static bool Load(const std::string &path, std::vector<CaptureThread> *out)
+        {
+            std::unique_ptr<FILE, int (*)(FILE *)> f(fopen(path.c_str(), "rb"), &fclose);
+            if (!f || fseek(f.get(), 0, SEEK_END) != 0)
+                return false;
+            long length = ftell(f.get());
+            if (length < 0 || fseek(f.get(), 0, SEEK_SET) != 0)
+                return false;
+            // counts come from the file: bound them by the bytes left so a
+            // truncated or corrupt capture fails here instead of in resize
+            auto remaining = [&]
+            {
+                long at = ftell(f.get());
+                return at < 0 || at > length ? std::uint64_t(0) : static_cast<std::uint64_t>(length - at);
+            };
+            const std::uint64_t thread_head = 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+            char magic[8];
+            std::uint32_t head[2];
+            if (fread(magic, 1, 8, f.get()) != 8 || memcmp(magic, Magic(), 8) != 0 || fread(head, sizeof(head), 1, f.get()) != 1)
+                return false;
+            if (head[0] > remaining() / thread_head)
+                return false;
+            out->clear();
+            out->resize(head[0]);
+            for (auto &t : *out)
+            {
+                std::uint32_t id[2];
+                std::uint64_t count;
+                if (fread(id, sizeof(id), 1, f.get()) != 1 || fread(&count, sizeof(count), 1, f.get()) != 1)
+                    return false;
+                if (count > remaining() / sizeof(CaptureRecord))
+                    return false;
+                t.thread = id[0];
+                t.records.resize(count);
+                if (count && fread(t.records.data(), sizeof(CaptureRecord), count, f.get()) != count)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        /// @brief 8 bytes with the terminating zero
+        static const char *Magic() { return "CTQCAP1"; }
+
+        static std::uint64_t NextId()
+        {
+            static std::atomic<std::uint64_t> next{1};
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        CaptureThread *Local()
+        {
+            struct Cache
+            {
+                std::uint64_t owner = 0;
+                CaptureThread *thread = nullptr;
+            };
+            static thread_local Cache cache;
+            if (cache.owner == id_)
+                return cache.thread;
+
+            std::unique_lock<std::mutex> lck(mutex_);
+            auto &slot = by_thread_[std::this_thread::get_id()];
+            if (!slot)
+            {
+                threads_.emplace_back(new CaptureThread);
+                slot = threads_.back().get();
+                slot->thread = static_cast<std::uint32_t>(threads_.size() - 1);
+                slot->records.reserve(per_thread_);
+            }
+            cache.owner = id_;
+            cache.thread = slot;
+            return slot;
+        }
+
+        std::uint64_t id_; ///< keys the thread local cache, never reused
+        std::size_t per_thread_;
+        std::int64_t start_ns_;
+        std::mutex mutex_;
+        std::map<std::thread::id, CaptureThread *> by_thread_;
+        std::vector<std::unique_ptr<CaptureThread>> threads_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * ---------------------------------------
+ * File: queue_clock.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Cheap nanosecond timestamps for queue instrumentation
+ */
+#ifndef _JULES_QUEUE_CLOCK_HPP_
+#define _JULES_QUEUE_CLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define JULES_CTQ_HAVE_TSC 1
+#endif
+
+namespace Jules::utils
+{
+    /// @brief nanosecond clock used by all queue instrumentation
+    /// @note reads the invariant TSC when the CPU has one, converted with a
+    ///       one-time calibration against steady_clock; otherwise falls back
+    ///       to steady_clock. Values share steady_clock's epoch. Set
+    ///       JULES_CTQ_CLOCK=steady to force the fallback.
+    ///       The calibration sleeps ~5 ms. It runs on the first call of
+    ///       Calibrate or NowNs; queues call Calibrate when instrumentation
+    ///       is enabled, before taking their lock, so it never stalls a
+    ///       critical section. TSCs of different cores may be slightly
+    ///       apart, so two readings on different threads (or one thread
+    ///       migrating) can go backwards by that skew: use ElapsedNs.
+    class QueueClock
+    {
+    public:
+        /// @brief run the one-time calibration now if it has not run yet
+        static void Calibrate()
+        {
+#ifdef JULES_CTQ_HAVE_TSC
+            Calibration();
+#endif
+        }
+
+        /// @brief current time in ns
+        static std::int64_t NowNs()
+        {
+#ifdef JULES_CTQ_HAVE_TSC
+            auto &c = Calibration();
+            if (c.use_tsc)
+            {
+                // signed: a core whose TSC is behind the calibrating one reads
+                // slightly below base_tsc
+                auto delta = static_cast<std::int64_t>(__rdtsc() - c.base_tsc);
+                if (delta < 0)
+                    delta = 0;
+                return c.base_ns + static_cast<std::int64_t>((static_cast<unsigned __int128>(delta) * c.mult) >> 32);
+            }
+#endif
+            return SteadyNs();
+        }
+
+        /// @brief ns from begin (an earlier NowNs) to now, 0 if the clock went backwards
+        static std::uint64_t ElapsedNs(std::int64_t begin)
+        {
+            auto dt = NowNs() - begin;
+            return dt > 0 ? static_cast<std::uint64_t>(dt) : 0;
+        }
+
+        /// @brief name of the time source in use, "tsc" or "steady_clock"
+        static const char *Source()
+        {
+#ifdef JULES_CTQ_HAVE_TSC
+            if (Calibration().use_tsc)
+                return "tsc";
+#endif
+            return "steady_clock";
+        }
+
+        static std::int64_t SteadyNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+    private:
+#ifdef JULES_CTQ_HAVE_TSC
+        struct Calib
+        {
+            bool use_tsc = false;
+            std::uint64_t base_tsc = 0;
+            std::int64_t base_ns = 0;
+            std::uint64_t mult = 0; ///< ns per tick, 32.32 fixed point
+        };
+
+        static bool InvariantTsc()
+        {
+            unsigned eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+                return false;
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx >> 8) & 1;
+        }
+
+        static Calib Measure()
+        {
+            Calib c;
+            auto *env = getenv("JULES_CTQ_CLOCK");
+            if ((env && strcmp(env, "steady") == 0) || !InvariantTsc())
+                return c;
+
+            auto ns0 = SteadyNs();
+            auto tsc0 = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            auto ns1 = SteadyNs();
+            auto tsc1 = __rdtsc();
+            if (tsc1 <= tsc0 || ns1 <= ns0)
+                return c;
+
+            c.mult = static_cast<std::uint64_t>(static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0) * 4294967296.0);
+            c.base_tsc = tsc1;
+            c.base_ns = ns1;
+            c.use_tsc = c.mult > 0;
+            return c;
+        }
+
+        static const Calib &Calibration()
+        {
+            static const Calib calib = Measure();
+            return calib;
+        }
+#endif
+    };
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * ---------------------------------------
+ * File: queue_hooks.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Compile-time instrumentation policies for CrossThreadQueue
+ */
+#ifndef _JULES_QUEUE_HOOKS_HPP_
+#define _JULES_QUEUE_HOOKS_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "queue_clock.hpp"
+#include "queue_stats.hpp"
+#include "queue_trace.hpp"
+
+namespace Jules::utils
+{
+    /// @brief default hooks policy, every call inlines to nothing
+    /// @note a hooks policy is a class with these five members; the queue owns
+    ///       one instance and calls it while holding its lock, once per element
+    struct NoHooks
+    {
+        void OnPush(const void * /* queue */, std::size_t /* size */) {}
+        void OnPop(const void * /* queue */, std::size_t /* size */) {}
+        void OnDrop(const void * /* queue */, std::size_t /* size */) {}
+        void OnWaitBegin(const void * /* queue */) {}
+        void OnWaitEnd(const void * /* queue */) {}
+    };
+
+    /// @brief counts operations, readable lock-free from any thread
+    /// @note hooks run under the queue lock, so each counter has one writer at
+    ///       a time: a relaxed load/store, no locked instruction and no shards
+    struct CounterHooks
+    {
+        void OnPush(const void *, std::size_t) { QueueCounters::Add(pushes, 1); }
+        void OnPop(const void *, std::size_t) { QueueCounters::Add(pops, 1); }
+        void OnDrop(const void *, std::size_t) { QueueCounters::Add(drops, 1); }
+        void OnWaitBegin(const void *) { QueueCounters::Add(waits, 1); }
+        void OnWaitEnd(const void *) {}
+
+        std::atomic<std::uint64_t> pushes{0};
+        std::atomic<std::uint64_t> pops{0};
+        std::atomic<std::uint64_t> drops{0};
+        std::atomic<std::uint64_t> waits{0};
+    };
+
+    /// @brief histograms of queue size seen by push and of consumer wait time
+    struct HistogramHooks
+    {
+        HistogramHooks() { QueueClock::Calibrate(); } // not under the queue lock later
+
+        void OnPush(const void *, std::size_t size) { depth.Record(size); }
+        void OnPop(const void *, std::size_t) {}
+        void OnDrop(const void *, std::size_t) {}
+        void OnWaitBegin(const void *) { WaitBegin() = QueueClock::NowNs(); }
+        void OnWaitEnd(const void *) { wait.Record(QueueClock::ElapsedNs(WaitBegin())); }
+
+        LatencyHistogram depth; ///< queue size after each push (values are counts, not ns)
+        LatencyHistogram wait;  ///< ns spent blocked in Pop_Limited or Pop_Must
+
+    private:
+        // several consumers may wait at once, a thread waits on one queue at a time
+        static std::int64_t &WaitBegin()
+        {
+            static thread_local std::int64_t begin = 0;
+            return begin;
+        }
+    };
+
+    /// @brief records every operation into TraceRecorder while it is started
+    struct TraceHooks
+    {
+        TraceHooks() { TraceRecorder::Instance(); } // calibrates the clock, not under the queue lock later
+
+        void OnPush(const void *queue, std::size_t size) { TraceRecorder::Instance().Record(TraceOp::Push, queue, size); }
+        void OnPop(const void *queue, std::size_t size) { TraceRecorder::Instance().Record(TraceOp::Pop, queue, size); }
+        void OnDrop(const void *queue, std::size_t size) { TraceRecorder::Instance().Record(TraceOp::Drop, queue, size); }
+        void OnWaitBegin(const void *queue) { TraceRecorder::Instance().Record(TraceOp::WaitBegin, queue, 0); }
+        void OnWaitEnd(const void *queue) { TraceRecorder::Instance().Record(TraceOp::WaitEnd, queue, 0); }
+    };
+
+    /// @brief combines two hooks policies
+    template <typename First, typename Second>
+    struct HookPair
+    {
+        void OnPush(const void *q, std::size_t size) { first.OnPush(q, size); second.OnPush(q, size); }
+        void OnPop(const void *q, std::size_t size) { first.OnPop(q, size); second.OnPop(q, size); }
+        void OnDrop(const void *q, std::size_t size) { first.OnDrop(q, size); second.OnDrop(q, size); }
+        void OnWaitBegin(const void *q) { first.OnWaitBegin(q); second.OnWaitBegin(q); }
+        void OnWaitEnd(const void *q) { first.OnWaitEnd(q); second.OnWaitEnd(q); }
+
+        First first;
+        Second second;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
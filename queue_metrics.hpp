@@ -0,0 +1,156 @@
+/*
+ * ---------------------------------------
+ * File: queue_metrics.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Prometheus text exposition of registered queues
+ */
+#ifndef _JULES_QUEUE_METRICS_HPP_
+#define _JULES_QUEUE_METRICS_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include "queue_registry.hpp"
+
+namespace Jules::utils
+{
+    /// @brief renders registered queues in Prometheus text format (version 0.0.4)
+    /// @note only lock-free counters are read, exporting never blocks producers
+    class PrometheusExporter
+    {
+    public:
+        /// @param prefix metric name prefix
+        /// @param registry registry to export
+        explicit PrometheusExporter(const std::string &prefix = "ctq",
+                                    QueueRegistry &registry = QueueRegistry::Instance())
+            : prefix_(prefix), registry_(registry)
+        {
+        }
+
+        /// @brief render every registered queue
+        std::string Render()
+        {
+            std::string pushed, popped, dropped, depth, capacity, sojourn, lock_wait, lock_hold;
+            registry_.ForEach([&](const std::string &name, const QueueRegistry::Source &source)
+                              {
+                auto label = "{queue=\"" + EscapeLabel(name) + "\"}";
+                auto &c = *source.counters;
+                auto cap = c.capacity.load(std::memory_order_relaxed);
+                pushed += Sample("_pushed_total", label, c.pushed.Load());
+                popped += Sample("_popped_total", label, c.popped.Load());
+                dropped += Sample("_dropped_total", label, c.dropped.Load());
+                depth += Sample("_depth", label, c.Depth());
+                if (cap != std::numeric_limits<std::uint64_t>::max())
+                    capacity += Sample("_capacity", label, cap);
+                if (source.latency && source.latency->Count() > 0)
+                    sojourn += Histogram("_sojourn_seconds", "queue=\"" + EscapeLabel(name) + "\"", *source.latency);
+                auto *profile = source.lock ? source.lock() : nullptr;
+                for (std::size_t i = 0; profile && i < LockProfile::kOps; i++)
+                {
+                    if (profile->wait[i].Count() == 0)
+                        continue;
+                    auto labels = "queue=\"" + EscapeLabel(name) + "\",op=\"" + QueueOpName(static_cast<QueueOp>(i)) + "\"";
+                    lock_wait += Histogram("_lock_wait_seconds", labels, profile->wait[i]);
+                    lock_hold += Histogram("_lock_hold_seconds", labels, profile->hold[i]);
+                } });
+
+            std::string out;
+            out += Family("_pushed_total", "counter", "Elements pushed into the queue.", pushed);
+            out += Family("_popped_total", "counter", "Elements popped from the queue.", popped);
+            out += Family("_dropped_total", "counter", "Elements removed by overflow, Clear or Erase.", dropped);
+            out += Family("_depth", "gauge", "Elements currently queued.", depth);
+            out += Family("_capacity", "gauge", "Configured max count of the queue.", capacity);
+            out += Family("_sojourn_seconds", "histogram", "Time elements spent queued.", sojourn);
+            out += Family("_lock_wait_seconds", "histogram", "Sampled time waiting for the queue mutex.", lock_wait);
+            out += Family("_lock_hold_seconds", "histogram", "Sampled time holding the queue mutex.", lock_hold);
+            return out;
+        }
+
+        /// @brief write to a local file for the node-exporter textfile collector
+        /// @note written to path.tmp then renamed, so scrapes never see a partial file
+        /// @param path target file, should end with .prom
+        /// @return true for written
+        bool WriteFile(const std::string &path)
+        {
+            auto content = Render();
+            auto tmp = path + ".tmp";
+            FILE *f = fopen(tmp.c_str(), "w");
+            if (!f)
+                return false;
+            bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+            ok = fclose(f) == 0 && ok;
+            if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+            {
+                remove(tmp.c_str());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t kFirstBucket = 10; ///< ~1us, finer buckets fold into it
+
+        std::string Family(const char *suffix, const char *type, const char *help, const std::string &samples) const
+        {
+            if (samples.empty())
+                return {};
+            auto name = prefix_ + suffix;
+            return "# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n" + samples;
+        }
+
+        std::string Sample(const char *suffix, const std::string &labels, std::uint64_t value) const
+        {
+            return prefix_ + suffix + labels + " " + std::to_string(value) + "\n";
+        }
+
+        std::string Histogram(const char *suffix, const std::string &queue, const LatencyHistogram &h) const
+        {
+            std::string out;
+            auto base = prefix_ + suffix;
+            char le[32];
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i + 1 < LatencyHistogram::kBuckets; i++)
+            {
+                cumulative += h.Bucket(i);
+                if (i < kFirstBucket)
+                    continue;
+                snprintf(le, sizeof(le), "%.9g", static_cast<double>(LatencyHistogram::UpperBound(i)) / 1e9);
+                out += base + "_bucket{" + queue + ",le=\"" + le + "\"} " + std::to_string(cumulative) + "\n";
+            }
+            cumulative += h.Bucket(LatencyHistogram::kBuckets - 1);
+            snprintf(le, sizeof(le), "%.9g", static_cast<double>(h.Sum()) / 1e9);
+            out += base + "_bucket{" + queue + ",le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+            out += base + "_sum{" + queue + "} " + le + "\n";
+            out += base + "_count{" + queue + "} " + std::to_string(cumulative) + "\n";
+            return out;
+        }
+
+        static std::string EscapeLabel(const std::string &in)
+        {
+            std::string out;
+            for (char ch : in)
+            {
+                if (ch == '\\' || ch == '"')
+                    out += '\\';
+                if (ch == '\n')
+                {
+                    out += "\\n";
+                    continue;
+                }
+                out += ch;
+            }
+            return out;
+        }
+
+        std::string prefix_;
+        QueueRegistry &registry_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * ---------------------------------------
+ * File: queue_probes.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - USDT static probes of queue operations (provider "jules_ctq")
+ *
+ * Probes, enabled by defining JULES_CTQ_USDT and having <sys/sdt.h>
+ * (systemtap-sdt-dev / systemtap-sdt-devel):
+ *   push(queue, size, count)   pop(queue, size, count)   drop(queue, size, count)
+ *   wait-begin(queue, size)    wait-end(queue, size)
+ * Each probe is a single nop in the code plus an ELF note, e.g.
+ *   bpftrace -e 'usdt:./ctQueue:jules_ctq:push { @[arg0] = hist(arg1); }'
+ * Without JULES_CTQ_USDT the macros expand to nothing.
+ */
+#ifndef _JULES_QUEUE_PROBES_HPP_
+#define _JULES_QUEUE_PROBES_HPP_
+
+#if defined(JULES_CTQ_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define JULES_CTQ_PROBE2(name, a1, a2) DTRACE_PROBE2(jules_ctq, name, a1, a2)
+#define JULES_CTQ_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(jules_ctq, name, a1, a2, a3)
+#else
+#warning "JULES_CTQ_USDT is defined but <sys/sdt.h> is missing, queue probes are disabled"
+#endif
+#endif
+
+#ifndef JULES_CTQ_PROBE2
+#define JULES_CTQ_PROBE2(name, a1, a2) \
+    do                                 \
+    {                                  \
+    } while (0)
+#define JULES_CTQ_PROBE3(name, a1, a2, a3) \
+    do                                     \
+    {                                      \
+    } while (0)
+#endif
+
+#endif
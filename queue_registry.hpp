@@ -0,0 +1,357 @@
+/*
+ * ---------------------------------------
+ * File: queue_registry.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Process wide registry of named queues for introspection
+ */
+#ifndef _JULES_QUEUE_REGISTRY_HPP_
+#define _JULES_QUEUE_REGISTRY_HPP_
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "queue_stats.hpp"
+
+namespace Jules::utils
+{
+    /// @brief state of a registered queue at dump time
+    struct QueueSnapshot
+    {
+        std::string name;
+        std::size_t depth = 0;
+        std::size_t capacity = 0;
+        std::uint64_t pushed = 0;
+        std::uint64_t popped = 0;
+        std::uint64_t dropped = 0;
+        double push_rate = 0; ///< elements per second since previous snapshot
+        double pop_rate = 0;  ///< elements per second since previous snapshot
+        std::uint64_t latency_count = 0;
+        std::uint64_t latency_mean_ns = 0;
+        std::uint64_t latency_p50_ns = 0;
+        std::uint64_t latency_p99_ns = 0;
+        std::uint64_t latency_max_ns = 0;
+    };
+
+    /// @brief registry of named queues
+    /// @note registration is optional and costs nothing on the queue hot path,
+    ///       snapshots read the lock-free counters of each queue
+    class QueueRegistry
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /// @brief what a registered queue exposes to the registry
+        struct Source
+        {
+            const QueueCounters *counters = nullptr;
+            const LatencyHistogram *latency = nullptr;
+            std::function<const LockProfile *()> lock; ///< may be empty or return null
+        };
+
+        /// @brief unregisters its queue when destroyed
+        class Registration
+        {
+        public:
+            Registration() = default;
+            Registration(QueueRegistry *registry, std::size_t id) : registry_(registry), id_(id) {}
+            Registration(const Registration &) = delete;
+            Registration &operator=(const Registration &) = delete;
+            Registration(Registration &&other) noexcept : registry_(other.registry_), id_(other.id_)
+            {
+                other.registry_ = nullptr;
+            }
+            Registration &operator=(Registration &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    Reset();
+                    registry_ = other.registry_;
+                    id_ = other.id_;
+                    other.registry_ = nullptr;
+                }
+                return *this;
+            }
+            ~Registration() { Reset(); }
+
+            void Reset()
+            {
+                if (registry_)
+                    registry_->Unregister(id_);
+                registry_ = nullptr;
+            }
+
+        private:
+            QueueRegistry *registry_ = nullptr;
+            std::size_t id_ = 0;
+        };
+
+        /// @brief process wide registry
+        static QueueRegistry &Instance()
+        {
+            static QueueRegistry registry;
+            return registry;
+        }
+
+        /// @brief register a queue under a name
+        /// @param name name shown in dumps
+        /// @param queue CrossThreadQueue (or any queue with Counters, Latency and LockStats)
+        /// @return handle keeping the queue registered
+        template <typename Queue>
+        Registration Register(const std::string &name, Queue &queue)
+        {
+            Source source;
+            source.counters = &queue.Counters();
+            source.latency = &queue.Latency();
+            source.lock = [&queue]
+            { return queue.LockStats(); };
+            return Register(name, std::move(source));
+        }
+
+        Registration Register(const std::string &name, Source source)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            auto &entry = entries_[next_id_];
+            entry.name = name;
+            entry.source = std::move(source);
+            entry.last_time = Clock::now();
+            entry.last_pushed = entry.source.counters->pushed.Load();
+            entry.last_popped = entry.source.counters->popped.Load();
+            return Registration(this, next_id_++);
+        }
+
+        /// @brief remove a queue
+        /// @param id registration id
+        void Unregister(std::size_t id)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            entries_.erase(id);
+        }
+
+        /// @brief visit every registered queue in registration order
+        /// @param fn called with a registry-owned source, do not keep it
+        void ForEach(const std::function<void(const std::string &, const Source &)> &fn)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            for (auto &kv : entries_)
+                fn(kv.second.name, kv.second.source);
+        }
+
+        /// @brief snapshot every registered queue, rates are since the previous snapshot
+        std::vector<QueueSnapshot> Snapshot()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            std::vector<QueueSnapshot> out;
+            out.reserve(entries_.size());
+            auto now = Clock::now();
+            for (auto &kv : entries_)
+                out.push_back(TakeSnapshot(kv.second, now));
+            return out;
+        }
+
+        /// @brief pass a snapshot of every queue to a callback
+        void Dump(const std::function<void(const QueueSnapshot &)> &fn)
+        {
+            for (auto &snap : Snapshot())
+                fn(snap);
+        }
+
+        /// @brief human readable table of every queue
+        std::string DumpText()
+        {
+            std::string out;
+            AppendFormat(out, "%-24s %8s %10s %12s %12s %10s %10s %10s %12s %12s\n",
+                         "queue", "depth", "capacity", "pushed", "popped", "dropped",
+                         "push/s", "pop/s", "p50(us)", "p99(us)");
+            for (auto &s : Snapshot())
+            {
+                AppendFormat(out, "%-24s %8zu %10s %12llu %12llu %10llu %10.1f %10.1f %12.1f %12.1f\n",
+                             s.name.c_str(), s.depth, CapacityText(s.capacity).c_str(),
+                             (unsigned long long)s.pushed, (unsigned long long)s.popped, (unsigned long long)s.dropped,
+                             s.push_rate, s.pop_rate, s.latency_p50_ns / 1e3, s.latency_p99_ns / 1e3);
+            }
+            out += DumpLockText();
+            return out;
+        }
+
+        /// @brief lock wait/hold table of queues with lock profiling enabled
+        std::string DumpLockText()
+        {
+            std::string out;
+            ForEach([&](const std::string &name, const Source &source)
+                    {
+                auto *profile = source.lock ? source.lock() : nullptr;
+                if (!profile)
+                    return;
+                for (std::size_t i = 0; i < LockProfile::kOps; i++)
+                {
+                    auto &wait = profile->wait[i];
+                    auto &hold = profile->hold[i];
+                    if (wait.Count() == 0)
+                        continue;
+                    if (out.empty())
+                    {
+                        AppendFormat(out, "%-24s %-10s %10s %12s %12s %12s %12s\n",
+                                     "queue", "op", "samples", "wait99(us)", "waitmax(us)", "hold99(us)", "holdmax(us)");
+                    }
+                    AppendFormat(out, "%-24s %-10s %10llu %12.1f %12.1f %12.1f %12.1f\n",
+                                 name.c_str(), QueueOpName(static_cast<QueueOp>(i)), (unsigned long long)wait.Count(),
+                                 wait.Quantile(0.99) / 1e3, wait.Max() / 1e3, hold.Quantile(0.99) / 1e3, hold.Max() / 1e3);
+                } });
+            return out;
+        }
+
+        /// @brief JSON array with one object per queue
+        std::string DumpJson()
+        {
+            std::string out = "[";
+            bool first = true;
+            for (auto &s : Snapshot())
+            {
+                // the name goes in unformatted, so its length is not bounded by a buffer
+                out += first ? "\n  {\"name\": \"" : ",\n  {\"name\": \"";
+                out += JsonEscape(s.name);
+                AppendFormat(out,
+                             "\", \"depth\": %zu, \"capacity\": %s, "
+                             "\"pushed\": %llu, \"popped\": %llu, \"dropped\": %llu, "
+                             "\"push_rate\": %.3f, \"pop_rate\": %.3f, "
+                             "\"latency_ns\": {\"count\": %llu, \"mean\": %llu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}}",
+                             s.depth,
+                             s.capacity == std::numeric_limits<std::size_t>::max() ? "null" : std::to_string(s.capacity).c_str(),
+                             (unsigned long long)s.pushed, (unsigned long long)s.popped, (unsigned long long)s.dropped,
+                             s.push_rate, s.pop_rate,
+                             (unsigned long long)s.latency_count, (unsigned long long)s.latency_mean_ns,
+                             (unsigned long long)s.latency_p50_ns, (unsigned long long)s.latency_p99_ns,
+                             (unsigned long long)s.latency_max_ns);
+                first = false;
+            }
+            out += first ? "]\n" : "\n]\n";
+            return out;
+        }
+
+        /// @brief write dump to a local file
+        /// @param path file path, replaced
+        /// @param json true for JSON false for text
+        /// @return true for written
+        bool DumpToFile(const std::string &path, bool json = false)
+        {
+            auto content = json ? DumpJson() : DumpText();
+            FILE *f = fopen(path.c_str(), "w");
+            if (!f)
+                return false;
+            bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+            return fclose(f) == 0 && ok;
+        }
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            Source source;
+            Clock::time_point last_time;
+            std::uint64_t last_pushed = 0;
+            std::uint64_t last_popped = 0;
+        };
+
+        static QueueSnapshot TakeSnapshot(Entry &e, Clock::time_point now)
+        {
+            QueueSnapshot s;
+            auto &c = *e.source.counters;
+            s.name = e.name;
+            s.pushed = c.pushed.Load();
+            s.popped = c.popped.Load();
+            s.dropped = c.dropped.Load();
+            s.depth = c.Depth();
+            auto capacity = c.capacity.load(std::memory_order_relaxed);
+            s.capacity = capacity > std::numeric_limits<std::size_t>::max()
+                             ? std::numeric_limits<std::size_t>::max()
+                             : static_cast<std::size_t>(capacity);
+
+            std::chrono::duration<double> dt = now - e.last_time;
+            if (dt.count() > 0)
+            {
+                s.push_rate = static_cast<double>(s.pushed - e.last_pushed) / dt.count();
+                s.pop_rate = static_cast<double>(s.popped - e.last_popped) / dt.count();
+            }
+            e.last_time = now;
+            e.last_pushed = s.pushed;
+            e.last_popped = s.popped;
+
+            if (auto *h = e.source.latency)
+            {
+                s.latency_count = h->Count();
+                s.latency_mean_ns = s.latency_count ? h->Sum() / s.latency_count : 0;
+                s.latency_p50_ns = h->Quantile(0.5);
+                s.latency_p99_ns = h->Quantile(0.99);
+                s.latency_max_ns = h->Max();
+            }
+            return s;
+        }
+
+        static std::string CapacityText(std::size_t capacity)
+        {
+            return capacity == std::numeric_limits<std::size_t>::max() ? "inf" : std::to_string(capacity);
+        }
+
+        static std::string JsonEscape(const std::string &in)
+        {
+            std::string out;
+            for (char ch : in)
+            {
+                auto uc = static_cast<unsigned char>(ch);
+                if (ch == '"' || ch == '\\')
+                {
+                    out += '\\';
+                    out += ch;
+                }
+                else if (uc < 0x20)
+                {
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", uc);
+                    out += esc;
+                }
+                else
+                    out += ch;
+            }
+            return out;
+        }
+
+        /// @brief printf into the end of out, growing it to whatever the format needs
+        static void AppendFormat(std::string &out, const char *fmt, ...)
+        {
+            va_list args;
+            va_start(args, fmt);
+            va_list again;
+            va_copy(again, args);
+            auto n = vsnprintf(nullptr, 0, fmt, args);
+            va_end(args);
+            if (n > 0)
+            {
+                auto at = out.size();
+                out.resize(at + static_cast<std::size_t>(n) + 1);
+                vsnprintf(&out[at], static_cast<std::size_t>(n) + 1, fmt, again);
+                out.resize(at + static_cast<std::size_t>(n));
+            }
+            va_end(again);
+        }
+
+        QueueRegistry() = default;
+
+        std::map<std::size_t, Entry> entries_;
+        std::size_t next_id_ = 0;
+        std::mutex mutex_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * ---------------------------------------
+ * File: queue_stats.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Statistics kept by queues, readable without taking the queue lock
+ */
+#ifndef _JULES_QUEUE_STATS_HPP_
+#define _JULES_QUEUE_STATS_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include "sharded_counter.hpp"
+
+namespace Jules::utils
+{
+    /// @brief monotonic statistic read lock-free by monitors
+    /// @note by default it has a single writer at a time (e.g. updated under
+    ///       the queue lock) and Add is a relaxed load/store pair, no locked
+    ///       instruction; a sharded one spreads concurrent writers over a
+    ///       ShardedCounter, for queues that count outside a lock
+    class QueueCounter
+    {
+    public:
+        explicit QueueCounter(bool sharded = false) : shards_(sharded ? new ShardedCounter<>() : nullptr) {}
+        QueueCounter(const QueueCounter &) = delete;
+        QueueCounter &operator=(const QueueCounter &) = delete;
+
+        void Add(std::uint64_t n = 1)
+        {
+            if (shards_)
+                shards_->Add(n);
+            else
+                value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t Load() const
+        {
+            return shards_ ? shards_->Load() : value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::uint64_t> value_{0};
+        std::unique_ptr<ShardedCounter<>> shards_;
+    };
+
+    /// @brief element counters of a queue
+    /// @note CrossThreadQueue updates them under its lock; HybridQueue, which
+    ///       counts on its lock-free path, builds them sharded. Readers
+    ///       (monitors, watchdog) load them lock-free either way
+    struct QueueCounters
+    {
+        /// @param sharded true when several threads may update a counter at once
+        explicit QueueCounters(bool sharded = false) : pushed(sharded), popped(sharded), dropped(sharded) {}
+
+        QueueCounter pushed;  ///< elements accepted
+        QueueCounter popped;  ///< elements handed to consumers
+        QueueCounter dropped; ///< elements removed by overflow, Clear or Erase
+        std::atomic<std::uint64_t> capacity{std::numeric_limits<std::uint64_t>::max()}; ///< gauge, mirrors SetMaxCount
+
+        /// @brief increment of a statistic with a single writer at a time (e.g.
+        ///        written under the queue lock): relaxed load/store, no locked instruction
+        static void Add(std::atomic<std::uint64_t> &c, std::uint64_t n)
+        {
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        /// @brief elements that left the queue
+        std::uint64_t Consumed() const
+        {
+            return popped.Load() + dropped.Load();
+        }
+
+        /// @brief approximate size, exact when no operation is in flight
+        std::size_t Depth() const
+        {
+            auto out = Consumed();
+            auto in = pushed.Load();
+            return in > out ? static_cast<std::size_t>(in - out) : 0;
+        }
+    };
+
+    /// @brief log2 bucketed histogram of durations in nanoseconds
+    /// @note same single writer rule as QueueCounters
+    class LatencyHistogram
+    {
+    public:
+        static constexpr std::size_t kBuckets = 48; ///< last bucket holds everything above 2^46 ns
+
+        /// @brief upper bound (inclusive) of bucket i in nanoseconds
+        static std::uint64_t UpperBound(std::size_t i)
+        {
+            return (std::uint64_t(1) << i) - 1;
+        }
+
+        static std::size_t BucketOf(std::uint64_t ns)
+        {
+            std::size_t i = 0;
+            while (ns)
+            {
+                ns >>= 1;
+                i++;
+            }
+            return i < kBuckets ? i : kBuckets - 1;
+        }
+
+        void Record(std::uint64_t ns)
+        {
+            QueueCounters::Add(buckets_[BucketOf(ns)], 1);
+            QueueCounters::Add(count_, 1);
+            QueueCounters::Add(sum_, ns);
+            if (ns > max_.load(std::memory_order_relaxed))
+                max_.store(ns, std::memory_order_relaxed);
+        }
+
+        std::uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+        std::uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+        std::uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+        std::uint64_t Bucket(std::size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+        /// @brief approximate quantile, upper bound of the bucket holding it
+        /// @param q quantile in [0, 1]
+        std::uint64_t Quantile(double q) const
+        {
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i < kBuckets; i++)
+                total += Bucket(i);
+            if (total == 0)
+                return 0;
+
+            auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < kBuckets; i++)
+            {
+                seen += Bucket(i);
+                if (seen >= rank)
+                    return i + 1 < kBuckets ? UpperBound(i) : Max();
+            }
+            return Max();
+        }
+
+    private:
+        std::atomic<std::uint64_t> buckets_[kBuckets] = {};
+        std::atomic<std::uint64_t> count_{0};
+        std::atomic<std::uint64_t> sum_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+
+    /// @brief queue operations told apart by lock profiling
+    enum class QueueOp : std::size_t
+    {
+        Push,
+        PushBatch,
+        Pop,
+        PopBatch,
+        Erase,
+        Clear,
+        Count
+    };
+
+    inline const char *QueueOpName(QueueOp op)
+    {
+        static const char *names[] = {"push", "push_batch", "pop", "pop_batch", "erase", "clear"};
+        return op < QueueOp::Count ? names[static_cast<std::size_t>(op)] : "unknown";
+    }
+
+    /// @brief queue mutex wait and hold times per operation
+    /// @note both histograms are recorded while the lock is held
+    struct LockProfile
+    {
+        static constexpr std::size_t kOps = static_cast<std::size_t>(QueueOp::Count);
+
+        explicit LockProfile(std::uint32_t every) : sample_every(every) {}
+
+        std::atomic<std::uint32_t> sample_every; ///< profile one in every N operations of a thread, 0 for off
+        LatencyHistogram wait[kOps];
+        LatencyHistogram hold[kOps];
+    };
+
+} // ! namespace Jules::utils
+
+#endif
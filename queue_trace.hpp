@@ -0,0 +1,304 @@
+/*
+ * ---------------------------------------
+ * File: queue_trace.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Per-thread binary event rings exported as Chrome trace JSON (Perfetto)
+ */
+#ifndef _JULES_QUEUE_TRACE_HPP_
+#define _JULES_QUEUE_TRACE_HPP_
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "queue_clock.hpp"
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Jules::utils
+{
+    enum class TraceOp : std::uint8_t
+    {
+        Push,
+        Pop,
+        Drop,
+        WaitBegin,
+        WaitEnd
+    };
+
+    /// @brief one queue operation, 24 bytes
+    struct TraceEvent
+    {
+        std::int64_t ts_ns;
+        const void *queue;
+        std::uint32_t size; ///< queue size after the operation
+        TraceOp op;
+    };
+
+    /// @brief events of one thread, the oldest are overwritten when full
+    struct TraceRing
+    {
+        explicit TraceRing(std::size_t capacity, std::uint32_t thread_id)
+            : events(capacity ? capacity : 1), tid(thread_id)
+        {
+        }
+
+        void Write(const TraceEvent &e)
+        {
+            auto w = written.load(std::memory_order_relaxed);
+            events[w % events.size()] = e;
+            written.store(w + 1, std::memory_order_release);
+        }
+
+        std::vector<TraceEvent> events;
+        std::atomic<std::uint64_t> written{0};
+        std::uint32_t tid;
+    };
+
+    /// @brief process wide trace of queue operations
+    /// @note each thread writes its own ring without locking; dump after Stop
+    ///       for an exact picture, events written during a dump may be torn.
+    ///       A thread's ring goes to a free list when the thread exits; its
+    ///       events stay in dumps until a new thread takes the ring over, so
+    ///       memory is bounded by the most threads tracing at once
+    class TraceRecorder
+    {
+    public:
+        static TraceRecorder &Instance()
+        {
+            static TraceRecorder recorder;
+            return recorder;
+        }
+
+        /// @brief start recording
+        /// @param events_per_thread ring size of threads that record for the first time
+        ///        (rings taken from the free list are resized to it)
+        void Start(std::size_t events_per_thread = 1 << 16)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            capacity_ = events_per_thread;
+            enabled_.store(true, std::memory_order_relaxed);
+        }
+
+        /// @brief stop recording, rings are kept for dumping
+        void Stop()
+        {
+            enabled_.store(false, std::memory_order_relaxed);
+        }
+
+        bool Enabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        /// @brief forget recorded events
+        void Reset()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            for (auto &ring : rings_)
+                ring->written.store(0, std::memory_order_relaxed);
+        }
+
+        /// @brief name shown for a queue in the trace
+        void NameQueue(const void *queue, const std::string &name)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            std::string escaped;
+            for (char ch : name)
+            {
+                if (ch == '"' || ch == '\\')
+                    escaped += '\\';
+                if (static_cast<unsigned char>(ch) >= 0x20)
+                    escaped += ch;
+            }
+            names_[queue] = escaped;
+        }
+
+        /// @brief record one event of the calling thread
+        void Record(TraceOp op, const void *queue, std::size_t size)
+        {
+            if (!Enabled())
+                return;
+            static thread_local Slot slot;
+            if (!slot.ring)
+                slot.ring = NewRing();
+            slot.ring->Write(TraceEvent{QueueClock::NowNs(), queue, static_cast<std::uint32_t>(size), op});
+        }
+
+        /// @brief render recorded events as Chrome trace JSON
+        /// @note each event is an instant on its thread, each queue also gets a
+        ///       counter track of its size
+        std::string ChromeJson()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            std::string out = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+            bool first = true;
+            auto next = [&]
+            {
+                out += first ? "\n" : ",\n";
+                first = false;
+            };
+
+            for (auto &ring : rings_)
+            {
+                next();
+                AppendFormat(out,
+                             "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"thread %u\"}}",
+                             ring->tid, ring->tid);
+
+                auto written = ring->written.load(std::memory_order_acquire);
+                auto cap = ring->events.size();
+                auto begin = written > cap ? written - cap : 0;
+                for (auto i = begin; i < written; i++)
+                {
+                    auto &e = ring->events[i % cap];
+                    auto name = QueueName(e.queue);
+                    auto ts = static_cast<double>(e.ts_ns - epoch_ns_) / 1e3;
+                    if (e.op == TraceOp::WaitBegin || e.op == TraceOp::WaitEnd)
+                    {
+                        next();
+                        AppendFormat(out,
+                                     "{\"name\": \"wait %s\", \"cat\": \"queue\", \"ph\": \"%s\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+                                     name.c_str(), e.op == TraceOp::WaitBegin ? "B" : "E", ts, ring->tid);
+                        continue;
+                    }
+                    next();
+                    AppendFormat(out,
+                                 "{\"name\": \"%s\", \"cat\": \"queue\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, "
+                                 "\"pid\": 1, \"tid\": %u, \"args\": {\"queue\": \"%s\", \"size\": %u}}",
+                                 OpName(e.op), ts, ring->tid, name.c_str(), e.size);
+                    next();
+                    AppendFormat(out,
+                                 "{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"size\": %u}}",
+                                 name.c_str(), ts, e.size);
+                }
+            }
+            out += "\n]}\n";
+            return out;
+        }
+
+        /// @brief write Chrome trace JSON to a local file
+        /// @return true for written
+        bool DumpChromeJson(const std::string &path)
+        {
+            auto content = ChromeJson();
+            FILE *f = fopen(path.c_str(), "w");
+            if (!f)
+                return false;
+            bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+            return fclose(f) == 0 && ok;
+        }
+
+        static const char *OpName(TraceOp op)
+        {
+            switch (op)
+            {
+            case TraceOp::Push:
+                return "push";
+            case TraceOp::Pop:
+                return "pop";
+            case TraceOp::Drop:
+                return "drop";
+            case TraceOp::WaitBegin:
+                return "wait_begin";
+            case TraceOp::WaitEnd:
+                return "wait_end";
+            }
+            return "unknown";
+        }
+
+    private:
+        /// @brief ring of the calling thread, back to the free list when the thread exits
+        struct Slot
+        {
+            TraceRing *ring = nullptr;
+            ~Slot()
+            {
+                if (ring)
+                    Instance().ReleaseRing(ring);
+            }
+        };
+
+        TraceRecorder() : epoch_ns_(QueueClock::NowNs()) {}
+
+        /// @return the ring released longest ago, else a new one
+        TraceRing *NewRing()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+#ifdef __linux__
+            auto tid = static_cast<std::uint32_t>(syscall(SYS_gettid));
+#else
+            auto tid = static_cast<std::uint32_t>(rings_.size() + 1);
+#endif
+            if (free_.empty())
+            {
+                rings_.emplace_back(new TraceRing(capacity_, tid));
+                return rings_.back().get();
+            }
+            auto *ring = free_.front();
+            free_.pop_front();
+            ring->events.resize(capacity_ ? capacity_ : 1);
+            ring->written.store(0, std::memory_order_relaxed);
+            ring->tid = tid;
+            return ring;
+        }
+
+        void ReleaseRing(TraceRing *ring)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            free_.push_back(ring);
+        }
+
+        /// @brief printf into the end of out, growing it to whatever the format needs
+        static void AppendFormat(std::string &out, const char *fmt, ...)
+        {
+            va_list args;
+            va_start(args, fmt);
+            va_list again;
+            va_copy(again, args);
+            auto n = vsnprintf(nullptr, 0, fmt, args);
+            va_end(args);
+            if (n > 0)
+            {
+                auto at = out.size();
+                out.resize(at + static_cast<std::size_t>(n) + 1);
+                vsnprintf(&out[at], static_cast<std::size_t>(n) + 1, fmt, again);
+                out.resize(at + static_cast<std::size_t>(n));
+            }
+            va_end(again);
+        }
+
+        std::string QueueName(const void *queue) const
+        {
+            auto it = names_.find(queue);
+            if (it != names_.end())
+                return it->second;
+            char buf[32];
+            snprintf(buf, sizeof(buf), "queue@%p", queue);
+            return buf;
+        }
+
+        std::atomic<bool> enabled_{false};
+        std::size_t capacity_ = 1 << 16;
+        std::int64_t epoch_ns_;
+        std::vector<std::unique_ptr<TraceRing>> rings_; ///< never shrinks, threads keep raw pointers
+        std::deque<TraceRing *> free_;                  ///< rings of exited threads, oldest release first
+        std::map<const void *, std::string> names_;
+        std::mutex mutex_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * ---------------------------------------
+ * File: queue_watchdog.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Detects queues that are non-empty while consumers make no progress
+ */
+#ifndef _JULES_QUEUE_WATCHDOG_HPP_
+#define _JULES_QUEUE_WATCHDOG_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "queue_stats.hpp"
+
+namespace Jules::utils
+{
+    /// @brief state of a watched queue at one sample
+    struct QueueHealth
+    {
+        std::string name;
+        std::size_t depth = 0;
+        std::chrono::milliseconds since_progress{0}; ///< time since a consumer last popped an element
+        std::chrono::milliseconds oldest_age{0};     ///< lower bound of head element age
+        std::uint64_t stalls = 0;                    ///< stall episodes seen so far
+        bool stalled = false;
+        bool dropping = false; ///< overflow, Clear or Erase removed elements since the previous sample
+    };
+
+    /// @brief samples queue counters on its own thread and reports stalls
+    /// @note the queues only bump counters; timing is derived from the
+    ///       samples, so precision equals the sample period
+    class QueueWatchdog
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using Callback = std::function<void(const QueueHealth &)>;
+
+        /// @param period sample period
+        explicit QueueWatchdog(std::chrono::milliseconds period = std::chrono::milliseconds(100))
+            : period_(period)
+        {
+        }
+        QueueWatchdog(const QueueWatchdog &) = delete;
+        QueueWatchdog &operator=(const QueueWatchdog &) = delete;
+
+        ~QueueWatchdog()
+        {
+            Stop();
+        }
+
+        /// @brief watch a queue, it must outlive the watch or be Unwatch-ed first
+        /// @param name name used in reports
+        /// @param queue any queue exposing Counters()
+        /// @param stall_after non-empty time without progress that counts as a stall
+        /// @return watch id
+        template <typename Queue>
+        std::size_t Watch(const std::string &name, const Queue &queue, std::chrono::milliseconds stall_after)
+        {
+            return Watch(name, queue.Counters(), stall_after);
+        }
+
+        std::size_t Watch(const std::string &name, const QueueCounters &counters, std::chrono::milliseconds stall_after)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            auto &entry = entries_[next_id_];
+            entry.counters = &counters;
+            entry.health.name = name;
+            entry.stall_after = stall_after;
+            entry.popped = counters.popped.Load();
+            entry.dropped = counters.dropped.Load();
+            entry.last_progress = Clock::now();
+            return next_id_++;
+        }
+
+        /// @brief stop watching a queue
+        /// @param id watch id
+        void Unwatch(std::size_t id)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            entries_.erase(id);
+        }
+
+        /// @brief set function called once per stall episode, on the sampling thread
+        void SetCallback(Callback cb)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            callback_ = std::move(cb);
+        }
+
+        /// @brief start sampling thread
+        void Start()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            if (thread_.joinable())
+                return;
+            stop_ = false;
+            thread_ = std::thread([this]
+                                  {
+                std::unique_lock<std::mutex> lck(mutex_);
+                while (!stop_)
+                {
+                    lck.unlock();
+                    Sample();
+                    lck.lock();
+                    wake_.wait_for(lck, period_, [this] { return stop_; });
+                } });
+        }
+
+        /// @brief stop sampling thread
+        void Stop()
+        {
+            {
+                std::unique_lock<std::mutex> lck(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            if (thread_.joinable())
+                thread_.join();
+        }
+
+        /// @brief take one sample of every queue, for callers driving their own loop
+        void Sample()
+        {
+            std::vector<QueueHealth> fired;
+            Callback cb;
+            {
+                std::unique_lock<std::mutex> lck(mutex_);
+                auto now = Clock::now();
+                for (auto &kv : entries_)
+                {
+                    if (SampleEntry(kv.second, now))
+                        fired.push_back(kv.second.health);
+                }
+                cb = callback_;
+            }
+            if (cb)
+            {
+                for (auto &health : fired)
+                    cb(health);
+            }
+        }
+
+        /// @brief get health of every watched queue as of the last sample
+        std::vector<QueueHealth> Snapshot()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            std::vector<QueueHealth> out;
+            out.reserve(entries_.size());
+            for (auto &kv : entries_)
+                out.push_back(kv.second.health);
+            return out;
+        }
+
+        /// @brief get number of stall episodes over all queues
+        std::uint64_t StallCount()
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            return stall_count_;
+        }
+
+    private:
+        struct Entry
+        {
+            const QueueCounters *counters = nullptr;
+            std::chrono::milliseconds stall_after{0};
+            std::uint64_t popped = 0;
+            std::uint64_t dropped = 0;
+            Clock::time_point last_progress;
+            std::deque<std::pair<Clock::time_point, std::uint64_t>> pushes; ///< (sample time, pushed)
+            QueueHealth health;
+        };
+
+        bool SampleEntry(Entry &e, Clock::time_point now)
+        {
+            auto popped = e.counters->popped.Load();
+            auto dropped = e.counters->dropped.Load();
+            auto consumed = popped + dropped;
+            auto pushed = e.counters->pushed.Load();
+            auto depth = pushed > consumed ? static_cast<std::size_t>(pushed - consumed) : 0;
+
+            // only pops are progress: a bounded queue whose consumer died keeps
+            // dropping on overflow, which must not hide the stall
+            e.health.dropping = dropped != e.dropped;
+            e.dropped = dropped;
+            if (popped != e.popped || depth == 0)
+            {
+                e.popped = popped;
+                e.last_progress = now;
+                e.health.stalled = false;
+            }
+
+            // element number 'consumed' is the head; it arrived after the last
+            // sample that had not seen it yet
+            if (e.pushes.empty() || e.pushes.back().second != pushed)
+                e.pushes.emplace_back(now, pushed);
+            while (e.pushes.size() > 1 && e.pushes.front().second <= consumed)
+                e.pushes.pop_front();
+
+            e.health.depth = depth;
+            e.health.since_progress = std::chrono::duration_cast<std::chrono::milliseconds>(now - e.last_progress);
+            e.health.oldest_age = depth == 0 || e.pushes.front().second <= consumed
+                                      ? std::chrono::milliseconds(0)
+                                      : std::chrono::duration_cast<std::chrono::milliseconds>(now - e.pushes.front().first);
+
+            if (depth > 0 && !e.health.stalled && e.health.since_progress >= e.stall_after)
+            {
+                e.health.stalled = true;
+                e.health.stalls++;
+                stall_count_++;
+                return true;
+            }
+            return false;
+        }
+
+        std::chrono::milliseconds period_;
+        std::map<std::size_t, Entry> entries_;
+        std::size_t next_id_ = 0;
+        std::uint64_t stall_count_ = 0;
+        Callback callback_;
+        bool stop_ = false;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::thread thread_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
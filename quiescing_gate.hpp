@@ -0,0 +1,95 @@
+/*
+ * ---------------------------------------
+ * File: quiescing_gate.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Many concurrent fast operations, rare exclusive ones that wait for
+ *   the fast ones to drain
+ */
+#ifndef _JULES_QUIESCING_GATE_HPP_
+#define _JULES_QUIESCING_GATE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include "sharded_counter.hpp"
+
+namespace Jules::utils
+{
+    /// @brief reader side of a Dekker style handshake: a fast operation
+    ///        bumps its own shard of an in-flight counter and checks the
+    ///        exclusive flag, an exclusive one raises the flag and waits for
+    ///        the counter to read zero, with a seq_cst fence on each side
+    /// @note fast operations never write a shared cache line; they block
+    ///       on the gate mutex only while an exclusive operation runs
+    class QuiescingGate
+    {
+    public:
+        QuiescingGate() = default;
+        QuiescingGate(const QuiescingGate &) = delete;
+        QuiescingGate &operator=(const QuiescingGate &) = delete;
+
+        /// @brief a fast operation in flight for the lifetime of the scope
+        class Scope
+        {
+        public:
+            explicit Scope(QuiescingGate &gate) : gate_(gate) { gate_.Enter(); }
+            ~Scope() { gate_.Leave(); }
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            QuiescingGate &gate_;
+        };
+
+        /// @brief run fn with no fast operation in flight
+        /// @note must not be called from inside a Scope of the same gate
+        template <typename Fn>
+        void Exclusive(Fn &&fn)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            exclusive_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (active_.Load() != 0)
+                std::this_thread::yield();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            fn();
+            exclusive_.store(false, std::memory_order_release);
+        }
+
+        /// @brief fast operations in flight, sums every shard
+        std::uint64_t Active() const { return active_.Load(); }
+
+    private:
+        void Enter()
+        {
+            for (;;)
+            {
+                active_.Add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!exclusive_.load(std::memory_order_acquire))
+                    return;
+                Leave();
+                std::unique_lock<std::mutex> lck(mutex_);
+            }
+        }
+
+        void Leave()
+        {
+            std::atomic_thread_fence(std::memory_order_release);
+            active_.Add(std::numeric_limits<std::uint64_t>::max()); // -1
+        }
+
+        ShardedCounter<> active_; ///< fast operations in flight, summed mod 2^64
+        std::atomic<bool> exclusive_{false};
+        std::mutex mutex_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif
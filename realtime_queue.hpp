@@ -0,0 +1,182 @@
+/*
+ * ---------------------------------------
+ * File: realtime_queue.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Real-time profile: storage fixed at construction, wait-free try-only
+ *   operations that neither allocate nor enter the kernel
+ */
+#ifndef _JULES_REALTIME_QUEUE_HPP_
+#define _JULES_REALTIME_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace Jules::utils
+{
+    /// @tparam T element type; copying and moving it must not allocate or
+    ///         throw, which rules out e.g. std::string or std::vector
+    /// @note Single producer, single consumer. The ring of capacity cells
+    ///       (rounded up to a power of two) is allocated and written once in
+    ///       the constructor; afterwards Try_Push, Pop and the batch forms
+    ///       are wait-free: a bounded number of steps, two relaxed/acquire
+    ///       loads and one release store, no lock, no allocation, no
+    ///       system call. There is no blocking Push or Pop: a real-time
+    ///       thread polls, the other side may sleep between polls.
+    ///       benchmark/bench_realtime checks the allocation and syscall
+    ///       claims at run time.
+    template <typename T>
+    class RealtimeQueue
+    {
+    public:
+        static_assert(std::is_nothrow_default_constructible<T>::value, "T must be nothrow default constructible");
+        static_assert(std::is_nothrow_copy_assignable<T>::value && std::is_nothrow_move_assignable<T>::value,
+                      "T must be nothrow copy and move assignable");
+        static_assert(ATOMIC_POINTER_LOCK_FREE == 2 && sizeof(std::size_t) == sizeof(void *),
+                      "std::atomic<std::size_t> must be always lock-free");
+
+        /// @param capacity max elements, rounded up to a power of two
+        explicit RealtimeQueue(std::size_t capacity)
+        {
+            cap_ = 2;
+            while (cap_ < capacity)
+                cap_ <<= 1;
+            mask_ = cap_ - 1;
+            cells_.reset(new T[cap_]()); // value-initialized: every page touched now
+        }
+        RealtimeQueue(const RealtimeQueue &) = delete;
+        RealtimeQueue &operator=(const RealtimeQueue &) = delete;
+
+        /// @brief max elements
+        std::size_t Capacity() const { return cap_; }
+
+        /// @brief elements queued, exact only from the producer or consumer thread while the other is idle
+        std::size_t Size() const
+        {
+            return tail_.pos.load(std::memory_order_acquire) - head_.pos.load(std::memory_order_acquire);
+        }
+
+        bool Empty() const { return Size() == 0; }
+
+        /// @brief producer side: push element if there is room
+        /// @param t element
+        /// @return true for pushed false for full
+        bool Try_Push(const T &t) noexcept
+        {
+            auto tail = tail_.pos.load(std::memory_order_relaxed);
+            if (!Room(tail, 1))
+                return false;
+            cells_[tail & mask_] = t;
+            tail_.pos.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Try_Push(T &&t) noexcept
+        {
+            auto tail = tail_.pos.load(std::memory_order_relaxed);
+            if (!Room(tail, 1))
+                return false;
+            cells_[tail & mask_] = std::move(t);
+            tail_.pos.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief producer side: push as many of n elements as fit, in order
+        /// @param ts elements
+        /// @param n count of elements
+        /// @return elements pushed, from 0 to n
+        std::size_t Try_Push(const T *ts, std::size_t n) noexcept
+        {
+            auto tail = tail_.pos.load(std::memory_order_relaxed);
+            if (!Room(tail, 1))
+                return 0;
+            auto free = cap_ - (tail - tail_.other);
+            if (n > free)
+                n = free;
+            for (std::size_t i = 0; i < n; i++)
+                cells_[(tail + i) & mask_] = ts[i];
+            tail_.pos.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        /// @brief consumer side: pop element if there is one
+        /// @param t pointer to poped element, may be null to discard
+        /// @return true for poped false for empty
+        bool Pop(T *t) noexcept
+        {
+            auto head = head_.pos.load(std::memory_order_relaxed);
+            if (!Available(head, 1))
+                return false;
+            if (t)
+                *t = std::move(cells_[head & mask_]);
+            head_.pos.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief consumer side: pop up to n elements into caller storage
+        /// @param ts destination, room for n elements
+        /// @param n max count of elements
+        /// @return elements poped
+        std::size_t Pop(T *ts, std::size_t n) noexcept
+        {
+            auto head = head_.pos.load(std::memory_order_relaxed);
+            if (!Available(head, 1))
+                return 0;
+            auto queued = head_.other - head;
+            if (n > queued)
+                n = queued;
+            for (std::size_t i = 0; i < n; i++)
+                ts[i] = std::move(cells_[(head + i) & mask_]);
+            head_.pos.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+    private:
+        /// @brief producer: room for n at tail, re-reading head only when the cached copy says full
+        bool Room(std::size_t tail, std::size_t n)
+        {
+            if (tail + n - tail_.other <= cap_)
+                return true;
+            tail_.other = head_.pos.load(std::memory_order_acquire);
+            return tail + n - tail_.other <= cap_;
+        }
+
+        /// @brief consumer: n queued at head, re-reading tail only when the cached copy says empty
+        bool Available(std::size_t head, std::size_t n)
+        {
+            if (head_.other - head >= n)
+                return true;
+            head_.other = tail_.pos.load(std::memory_order_acquire);
+            return head_.other - head >= n;
+        }
+
+        /// @brief an index and the owner's cached copy of the other side's,
+        ///        followed by a full line of padding: 64 bytes between the hot
+        ///        fields of neighbours keep them on separate cache lines at any
+        ///        alignment, and unlike alignas the queue stays heap allocatable
+        ///        in C++14
+        struct Side
+        {
+            std::atomic<std::size_t> pos{0};
+            std::size_t other = 0;
+            char pad[64];
+        };
+
+        std::unique_ptr<T[]> cells_; ///< read-only after construction, like cap_ and mask_
+        std::size_t cap_ = 0;
+        std::size_t mask_ = 0;
+        char pad_[64];
+
+        Side tail_; ///< written by the producer
+        Side head_; ///< written by the consumer
+    };
+
+} // ! namespace Jules::utils
+
+#endif
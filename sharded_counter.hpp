@@ -0,0 +1,102 @@
+/*
+ * ---------------------------------------
+ * File: sharded_counter.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Counter split over cache-line padded cells, summed on read
+ */
+#ifndef _JULES_SHARDED_COUNTER_HPP_
+#define _JULES_SHARDED_COUNTER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace Jules::utils
+{
+    /// @brief cell of the calling thread, threads are spread round robin
+    inline std::size_t CurrentShard()
+    {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+        return shard;
+    }
+
+    /// @brief counter written by many threads without sharing a cache line
+    /// @note Add is a relaxed fetch_add on the caller's own cell, so writers
+    ///       on different threads never contend unless there are more threads
+    ///       than Shards; Load sums all cells and is meant for monitors.
+    ///       The cells live in their own malloc block, aligned by hand, so the
+    ///       counter and the objects holding it are not over-aligned types
+    ///       (C++14 operator new only guarantees alignof(std::max_align_t));
+    ///       malloc rather than operator new lets a replaced operator new
+    ///       count itself with one (benchmark/alloc_counter.hpp)
+    template <std::size_t Shards = 16>
+    class ShardedCounter
+    {
+    public:
+        static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "Shards must be a power of two");
+
+        ShardedCounter() : storage_(std::malloc(sizeof(Cell) * Shards + kLine - 1), &std::free)
+        {
+            if (!storage_)
+                throw std::bad_alloc();
+            void *p = storage_.get();
+            std::size_t space = sizeof(Cell) * Shards + kLine - 1;
+            cells_ = static_cast<Cell *>(std::align(kLine, sizeof(Cell) * Shards, p, space));
+            for (std::size_t i = 0; i < Shards; i++)
+                new (&cells_[i]) Cell();
+        }
+        ShardedCounter(const ShardedCounter &) = delete;
+        ShardedCounter &operator=(const ShardedCounter &) = delete;
+
+        void Add(std::uint64_t n = 1)
+        {
+            cells_[CurrentShard() & (Shards - 1)].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// @brief add through a shard index cached by the caller
+        void Add(std::size_t shard, std::uint64_t n)
+        {
+            cells_[shard & (Shards - 1)].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// @brief sum of all cells, not a snapshot while writers are active
+        std::uint64_t Load() const
+        {
+            std::uint64_t sum = 0;
+            for (std::size_t i = 0; i < Shards; i++)
+                sum += cells_[i].value.load(std::memory_order_relaxed);
+            return sum;
+        }
+
+        /// @brief set to zero, only exact while no writer is active
+        void Reset()
+        {
+            for (std::size_t i = 0; i < Shards; i++)
+                cells_[i].value.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr std::size_t kLine = 64;
+
+        /// @brief one cache line per cell; only ever placement-constructed in storage_
+        struct Cell
+        {
+            std::atomic<std::uint64_t> value{0};
+            char pad[kLine - sizeof(std::atomic<std::uint64_t>)];
+        };
+
+        std::unique_ptr<void, void (*)(void *)> storage_;
+        Cell *cells_ = nullptr; ///< Shards cells inside storage_, line aligned
+    };
+
+} // ! namespace Jules::utils
+
+#endif
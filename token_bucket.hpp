@@ -0,0 +1,98 @@
+/*
+ * ---------------------------------------
+ * File: token_bucket.hpp
+ * Created  Date: 2026-10-18
+ * Author:  Jules
+ * Contact: https://github.com/jules-ai
+ * ---------------------------------------
+ * - Compatible with C++14 or higher
+ * - Token bucket used to pace consumers
+ */
+#ifndef _JULES_TOKEN_BUCKET_HPP_
+#define _JULES_TOKEN_BUCKET_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace Jules::utils
+{
+    /// @brief thread safe token bucket, refilled continuously at rate up to burst
+    class TokenBucket
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /// @param rate tokens per second
+        /// @param burst max tokens stored, bucket starts full
+        TokenBucket(double rate, double burst)
+            : rate_(rate), burst_(std::max(burst, 1.0)), tokens_(burst_), last_(Clock::now())
+        {
+        }
+        TokenBucket(const TokenBucket &) = delete;
+        TokenBucket &operator=(const TokenBucket &) = delete;
+
+        /// @brief change rate and burst, stored tokens are kept up to burst
+        void SetRate(double rate, double burst)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            Refill(Clock::now());
+            rate_ = rate;
+            burst_ = std::max(burst, 1.0);
+            tokens_ = std::min(tokens_, burst_);
+        }
+
+        /// @brief take up to n whole tokens
+        /// @param n wanted tokens
+        /// @param now current time
+        /// @param ready set to the time one token is available when nothing was taken
+        /// @return number of tokens taken
+        std::size_t Take(std::size_t n, Clock::time_point now, Clock::time_point *ready = nullptr)
+        {
+            std::unique_lock<std::mutex> lck(mutex_);
+            Refill(now);
+            auto got = std::min<std::size_t>(n, static_cast<std::size_t>(tokens_));
+            if (got > 0)
+            {
+                tokens_ -= static_cast<double>(got);
+                return got;
+            }
+            if (ready)
+            {
+                if (rate_ <= 0)
+                    *ready = Clock::time_point::max();
+                else
+                    *ready = now + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>((1.0 - tokens_) / rate_)) +
+                             Clock::duration(1);
+            }
+            return 0;
+        }
+
+        /// @brief try to take one token
+        /// @return true for taken
+        bool Try_Take()
+        {
+            return Take(1, Clock::now()) == 1;
+        }
+
+    private:
+        void Refill(Clock::time_point now)
+        {
+            if (now <= last_)
+                return;
+            std::chrono::duration<double> dt = now - last_;
+            tokens_ = std::min(burst_, tokens_ + dt.count() * rate_);
+            last_ = now;
+        }
+
+        std::mutex mutex_;
+        double rate_;
+        double burst_;
+        double tokens_;
+        Clock::time_point last_;
+    };
+
+} // ! namespace Jules::utils
+
+#endif